@@ -3,300 +3,695 @@
 #include "PositionState.h"
 #include "PositionEvaluation.h"
 #include "TranspositionTable.h"
-#include <mutex>
+#include "MemPool.h"
+#include "Uci.h"
+#include "SearchStats.h"
+#include <thread>
+#include <algorithm>
+#include <cmath>
 
 namespace pismo
 {
 namespace UCI
 {
-extern bool stopSearch;
-extern std::mutex stopMtx;
+extern std::atomic<bool> stopSearch;
 }
 
-MoveInfo ABCore::think(PositionState& pos, uint16_t depth)
+// Returns true if the stored evaluation is enough to
+// return it without searching for the window (alpha, beta)
+inline bool evalCutsWindow(const EvalInfo& eval, int16_t alpha, int16_t beta)
 {
+	return eval.bound == EXACT_BOUND ||
+		(eval.bound == LOWER_BOUND && eval.posValue >= beta) ||
+		(eval.bound == UPPER_BOUND && eval.posValue <= alpha);
+}
+
+// Mate scores are stored in the transposition table relative
+// to the stored position and are converted back relative
+// to the root when they are read at the given ply
+inline int16_t scoreToTT(int16_t score, uint16_t ply)
+{
+	if (score >= MATE_BOUND) {
+		return score + ply;
+	}
+	if (score <= -MATE_BOUND) {
+		return score - ply;
+	}
+	return score;
+}
+
+inline int16_t scoreFromTT(int16_t score, uint16_t ply)
+{
+	if (score >= MATE_BOUND) {
+		return score - ply;
+	}
+	if (score <= -MATE_BOUND) {
+		return score + ply;
+	}
+	return score;
+}
+
+// Returns the bound type of the score searched with the window (alpha, beta)
+inline BoundType scoreBound(int16_t score, int16_t alpha, int16_t beta)
+{
+	if (score <= alpha) {
+		return UPPER_BOUND;
+	}
+	if (score >= beta) {
+		return LOWER_BOUND;
+	}
+	return EXACT_BOUND;
+}
+
+MoveInfo ABCore::think(PositionState& pos, uint16_t depth, unsigned int softTimeLimit, bool infinite, uint64_t nodeLimit)
+{
+	_startTime = std::chrono::steady_clock::now();
+	_softTimeLimit = softTimeLimit;
+	_infinite = infinite;
+	_nodeLimit = nodeLimit;
+
+	if (depth >= MAX_SEARCH_DEPTH) {
+		depth = MAX_SEARCH_DEPTH - 1;
+	}
+	_transTable->newSearch();
+
+	// the node counters are reset before the helpers start, so
+	// that the counts of the previous search are never summed
+	_nodeCount = 0;
+	for (std::size_t i = 0; i < _helpers.size(); ++i) {
+		_helpers[i]->_nodeCount = 0;
+	}
+
+	STATS_RESET_HELPERS();
+	std::vector<std::thread> helperThreads;
+	for (std::size_t i = 0; i < _helpers.size(); ++i) {
+		_helpers[i]->_helperStop = false;
+		*(_helpers[i]->_helperPos) = pos;
+		// Every other helper searches one ply deeper, so that the threads
+		// do not follow each other through the same tree
+		helperThreads.push_back(std::thread(&ABCore::helperThink, _helpers[i], depth + (i % 2 == 0 ? 1 : 0)));
+	}
+
 	_pos = &pos;
+	MoveInfo move = iterativeDeepening(depth);
+
+	for (std::size_t i = 0; i < _helpers.size(); ++i) {
+		_helpers[i]->_helperStop = true;
+	}
+	for (std::size_t i = 0; i < helperThreads.size(); ++i) {
+		helperThreads[i].join();
+	}
+	STATS_PRINT();
+
+	return move;
+}
+
+void ABCore::helperThink(uint16_t depth)
+{
+	MemPool::initMoveGenInfo();
+	MemPool::initCheckPinInfo();
+	_pos = _helperPos;
+	iterativeDeepening(depth < MAX_SEARCH_DEPTH ? depth : MAX_SEARCH_DEPTH - 1);
+	STATS_MERGE_HELPER();
+	MoveGenerator::instance()->destroy();
+	MemPool::destroyMoveGenInfo();
+	MemPool::destroyCheckPinInfo();
+}
+
+uint64_t ABCore::nodeCount() const
+{
+	uint64_t nodeCount = _nodeCount.load(std::memory_order_relaxed);
+	for (std::size_t i = 0; i < _helpers.size(); ++i) {
+		nodeCount += _helpers[i]->_nodeCount.load(std::memory_order_relaxed);
+	}
+
+	return nodeCount;
+}
+
+void ABCore::setThreadCount(unsigned int threadCount)
+{
+	if (threadCount < 1) {
+		threadCount = 1;
+	}
+	else if (threadCount > MAX_THREAD_COUNT) {
+		threadCount = MAX_THREAD_COUNT;
+	}
+
+	while (_helpers.size() + 1 > threadCount) {
+		delete _helpers.back();
+		_helpers.pop_back();
+	}
+	while (_helpers.size() + 1 < threadCount) {
+		_helpers.push_back(new ABCore(_transTable));
+	}
+}
+
+void ABCore::setHashSize(unsigned int sizeMB)
+{
+	_transTable->resize(sizeMB);
+}
+
+void ABCore::clearHash()
+{
+	_transTable->clear();
+}
+
+MoveInfo ABCore::iterativeDeepening(uint16_t depth)
+{
 	_moveGen = MoveGenerator::instance();
+	_moveGen->resetMoveHeuristics();
+	_selDepth = 0;
+	_stopped = false;
+	STATS_RESET();
+	generateRootMoves();
+	if (_rootMoves.empty()) {
+		return MATE_MOVE;
+	}
 
-	_moveGen->prepareMoveGeneration(_pos->kingUnderCheck() ? EVASION_SEARCH : USUAL_SEARCH,
-			MoveInfo(), depth);
-	_pos->initCheckPinInfo(depth);
+	MoveInfo bestMove = _rootMoves[0].move;
+	int16_t bestScore = 0;
+	for (uint16_t currentDepth = 1; currentDepth <= depth; ++currentDepth) {
+		int alpha = -MAX_SCORE;
+		int beta = MAX_SCORE;
+		if (currentDepth >= ASP_DEPTH) {
+			alpha = std::max(bestScore - ASP_WINDOW, -MAX_SCORE);
+			beta = std::min(bestScore + ASP_WINDOW, (int) MAX_SCORE);
+		}
 
-	MoveInfo generatedMove = _moveGen->getTopMove(*_pos, depth);
-	MoveInfo move = MATE_MOVE;
-	int16_t score;
-	if (_pos->whiteToPlay()) {
-		score = -MAX_SCORE;
-		while(generatedMove.from != INVALID_SQUARE) {
-			std::unique_lock<std::mutex> timerLck(UCI::stopMtx);
-			if (UCI::stopSearch) {
-				break;
+		int16_t score;
+		uint16_t tryCount = 0;
+		while (true) {
+			if (!searchRoot(currentDepth, alpha, beta, score)) {
+				// The iteration is not finished, so the best move
+				// of the last finished iteration is returned
+				return bestMove;
 			}
-			timerLck.unlock();
-			if (_pos->pseudoMoveIsLegalMove(generatedMove)) {
-				if (move.from == INVALID_SQUARE) {
-					move = generatedMove;
-				}
-				_pos->makeMove(generatedMove);
-				int16_t s = alphaBetaIterative(depth - 1, score, MAX_SCORE);
-				_pos->undoMove();
-				if (s > score) {
-					score = s;
-					move = generatedMove;
-				}
-				_pos->updateCheckPinInfo(depth);
+			if (score <= alpha && alpha > -MAX_SCORE) {
+				alpha = tryCount < MAX_TRY ? std::max(alpha - (tryCount + 1) * DELTA, -MAX_SCORE) : -MAX_SCORE;
+				++tryCount;
 			}
-			generatedMove = _moveGen->getTopMove(*_pos, depth);
-		}
-	}
-	else {
-		score = MAX_SCORE;
-		while(generatedMove.from != INVALID_SQUARE) {
-			std::unique_lock<std::mutex> timerLck(UCI::stopMtx);
-			if (UCI::stopSearch) {
-				break;
+			else if (score >= beta && beta < MAX_SCORE) {
+				beta = tryCount < MAX_TRY ? std::min(beta + (tryCount + 1) * DELTA, (int) MAX_SCORE) : MAX_SCORE;
+				++tryCount;
 			}
-			timerLck.unlock();
-			if (_pos->pseudoMoveIsLegalMove(generatedMove)) {
-				if (move.from == INVALID_SQUARE) {
-					move = generatedMove;
-				}
-				_pos->makeMove(generatedMove);
-				int16_t s = alphaBetaIterative(depth - 1, -MAX_SCORE, score);
-				_pos->undoMove();
-				if (s < score) {
-					score = s;
-					move = generatedMove;
-				}
-				_pos->updateCheckPinInfo(depth);
+			else {
+				break;
 			}
-			generatedMove = _moveGen->getTopMove(*_pos, depth);
+		}
+
+		bestMove = _rootMoves[0].move;
+		bestScore = score;
+		STATS_SET(iterationNodes[currentDepth], _nodeCount.load(std::memory_order_relaxed));
+		EvalInfo eval(score, _pos->getZobKey(), currentDepth, EXACT_BOUND, bestMove);
+		_transTable->push(eval);
+		if (_printInfo) {
+			printSearchInfo(currentDepth, score);
+		}
+		if (isMateScore(score) && !_infinite) {
+			break;
+		}
+		if (_softTimeLimit && elapsedTime() >= _softTimeLimit) {
+			break;
 		}
 	}
-	
-	EvalInfo eval(score, pos.getZobKey(), depth);
-	_transTable->push(eval);
 
-	return move;
+	return bestMove;
 }
 
-int16_t ABCore::alphaBetaIterative(uint16_t depth, int16_t alpha, int16_t beta)
+void ABCore::generateRootMoves()
 {
-	int16_t score;
-	uint16_t currentDepth = 0;
+	_rootMoves.clear();
+	EvalInfo eval;
+	_transTable->contains(*_pos, eval);
+	// Depth 0 of the memory pool is not used by the search,
+	// as alphaBeta switches to quiescence search on depth 0
+	_moveGen->prepareMoveGeneration(_pos->kingUnderCheck() ? EVASION_SEARCH : USUAL_SEARCH,
+			eval.move, 0);
+	_pos->initCheckPinInfo(0);
+	MoveInfo generatedMove = _moveGen->getTopMove(*_pos, 0);
+	while(generatedMove.from != INVALID_SQUARE) {
+		if (_pos->pseudoMoveIsLegalMove(generatedMove)) {
+			RootMove rootMove = {generatedMove, -MAX_SCORE, 0};
+			_rootMoves.push_back(rootMove);
+		}
+		generatedMove = _moveGen->getTopMove(*_pos, 0);
+	}
+}
+
+bool ABCore::rootMoveOrder(const RootMove& first, const RootMove& second)
+{
+	if (first.score != second.score) {
+		return first.score > second.score;
+	}
+	return first.nodeCount > second.nodeCount;
+}
+
+bool ABCore::searchRoot(uint16_t depth, int16_t alpha, int16_t beta, int16_t& score)
+{
+	_pos->initCheckPinInfo(depth);
+	for (std::size_t i = 0; i < _rootMoves.size(); ++i) {
+		_rootMoves[i].score = -MAX_SCORE;
+	}
+
+	score = -MAX_SCORE;
 	int16_t currentAlpha = alpha;
-	int16_t currentBeta = beta;
-	uint16_t tryCount = 0;
-	while (currentDepth <= depth) {
-		score = alphaBeta(currentDepth, currentAlpha, currentBeta);
-		if (score == MAX_SCORE || score == -MAX_SCORE) {
-			return score;
+	std::size_t bestIndex = 0;
+	_pvLength[0] = 0;
+	for (std::size_t i = 0; i < _rootMoves.size(); ++i) {
+		if (pollStop()) {
+			return false;
 		}
-		if (score <= currentAlpha) {
-			if (tryCount < MAX_TRY) {
-				currentAlpha -= (tryCount + 1) * DELTA;
-				++tryCount;
-			}
-			else {
-				currentAlpha = -MAX_SCORE;
+		RootMove& rootMove = _rootMoves[i];
+		if (_printInfo && elapsedTime() >= CURRMOVE_INFO_TIME) {
+			UCI::printCurrentMove(depth, rootMove.move, i + 1);
+		}
+		uint64_t nodeCount = _nodeCount;
+		_pos->makeMove(rootMove.move);
+		int16_t s;
+		if (i == 0) {
+			s = -alphaBeta(depth - 1, 1, -beta, -currentAlpha);
+		}
+		else {
+			s = -alphaBeta(depth - 1, 1, -currentAlpha - 1, -currentAlpha);
+			if (s > currentAlpha && s < beta) {
+				s = -alphaBeta(depth - 1, 1, -beta, -currentAlpha);
 			}
 		}
-		else if (score >= currentBeta) {
-			if (tryCount < MAX_TRY) {
-				currentBeta += (tryCount + 1) * DELTA;
-				++tryCount;
+		_pos->undoMove();
+		_pos->updateCheckPinInfo(depth);
+		if (_stopped) {
+			return false;
+		}
+		rootMove.score = s;
+		rootMove.nodeCount = _nodeCount - nodeCount;
+		if (s > score) {
+			score = s;
+			bestIndex = i;
+			if (score > currentAlpha) {
+				currentAlpha = score;
+				updatePV(0, rootMove.move);
 			}
-			else {
-				currentBeta = MAX_SCORE;
+			if (score >= beta) {
+				break;
 			}
 		}
-		else {
-			if (currentDepth >= ASP_DEPTH) { 
-				currentAlpha = score - ASP_WINDOW;
-				currentBeta = score + ASP_WINDOW;
-			}
-			tryCount = 0;
-			++currentDepth;
+	}
+
+	// The best move goes first, the others are ordered
+	// by their scores and the sizes of their subtrees
+	// (the scores of the moves which failed low are
+	// upper bounds and may be equal to the best score)
+	std::rotate(_rootMoves.begin(), _rootMoves.begin() + bestIndex, _rootMoves.begin() + bestIndex + 1);
+	std::stable_sort(_rootMoves.begin() + 1, _rootMoves.end(), rootMoveOrder);
+	return true;
+}
+
+void ABCore::updatePV(uint16_t ply, const MoveInfo& move)
+{
+	_pvTable[ply][0] = move;
+	_pvLength[ply] = 1;
+	if (ply + 1 < MAX_SEARCH_DEPTH) {
+		for (uint16_t i = 0; i < _pvLength[ply + 1] && i + 1 < MAX_SEARCH_DEPTH; ++i) {
+			_pvTable[ply][i + 1] = _pvTable[ply + 1][i];
 		}
+		_pvLength[ply] = std::min(_pvLength[ply + 1] + 1, MAX_SEARCH_DEPTH);
 	}
-	
-	return score;
 }
 
-int16_t ABCore::alphaBeta(uint16_t depth, int16_t alpha, int16_t beta)
+uint64_t ABCore::elapsedTime() const
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - _startTime).count();
+}
+
+void ABCore::printSearchInfo(uint16_t depth, int16_t score) const
+{
+	UCI::printSearchInfo(depth, _selDepth, score, nodeCount(), elapsedTime(),
+			_transTable->hashfull(), _pvTable[0], _pvLength[0]);
+}
+
+bool ABCore::pollStop()
+{
+	if (!_stopped) {
+		_stopped = _helperStop.load(std::memory_order_relaxed) || UCI::stopSearch.load(std::memory_order_relaxed) ||
+			(_nodeLimit && nodeCount() >= _nodeLimit);
+	}
+	return _stopped;
+}
+
+// The stop flags are polled only every STOP_CHECK_NODE_COUNT nodes,
+// once the search is stopped every node returns immediately, and
+// the results of the stopped subtrees are not stored
+bool ABCore::searchIsStopped()
+{
+	if ((_nodeCount.load(std::memory_order_relaxed) & (STOP_CHECK_NODE_COUNT - 1)) == 0) {
+		pollStop();
+	}
+	return _stopped;
+}
+
+int16_t ABCore::alphaBeta(uint16_t depth, uint16_t ply, int16_t alpha, int16_t beta)
 {
+	_pvLength[ply] = 0;
+	// the root position is not checked, as the search should
+	// return a move even if the game is already drawn
+	if (_pos->isDraw()) {
+		return DRAW_SCORE;
+	}
 	if (depth == 0) {
-		return quiescenceSearch(depth, alpha, beta);
+		return quiescenceSearch(depth, ply, alpha, beta);
+	}
+	countNode();
+	if (ply > _selDepth) {
+		_selDepth = ply;
 	}
+	if (searchIsStopped()) {
+		return 0;
+	}
+	STATS_INCR(mainNodes);
 
+	bool isPVNode = beta - alpha > 1;
 	EvalInfo eval;
-	if (_transTable->contains(*_pos, eval) && eval.depth >= depth) {
-		return eval.posValue;
+	STATS_INCR(ttProbes[depth]);
+	if (_transTable->contains(*_pos, eval)) {
+		STATS_INCR(ttHits[depth]);
+		eval.posValue = scoreFromTT(eval.posValue, ply);
+		// the PV nodes are searched, so that the full PV is collected
+		if (!isPVNode && eval.depth >= depth && evalCutsWindow(eval, alpha, beta)) {
+			STATS_INCR(ttCutoffs[depth]);
+			return eval.posValue;
+		}
+	}
+
+	int16_t nullScore;
+	if (beta - alpha == 1 && nullMoveCutoff(depth, ply, beta, nullScore)) {
+		eval = EvalInfo(scoreToTT(nullScore, ply), _pos->getZobKey(), depth, LOWER_BOUND, eval.move);
+		_transTable->forcePush(eval);
+		return nullScore;
+	}
+	if (_stopped) {
+		return 0;
 	}
 
 	_moveGen->prepareMoveGeneration(_pos->kingUnderCheck() ? EVASION_SEARCH : USUAL_SEARCH,
-			MoveInfo(), depth);
+			eval.move, depth, ply);
 	_pos->initCheckPinInfo(depth);
 
 	MoveInfo generatedMove = _moveGen->getTopMove(*_pos, depth);
 
-	int16_t score;
+	MoveInfo bestMove;
+	int16_t score = -MAX_SCORE;
 	int16_t currentAlpha = alpha;
-	int16_t currentBeta = beta;
-	if (_pos->whiteToPlay()) {
-		score = -MAX_SCORE;
-		while(generatedMove.from != INVALID_SQUARE) {
-			if (_pos->pseudoMoveIsLegalMove(generatedMove)) {
-				_pos->makeMove(generatedMove);
-				int16_t s = alphaBeta(depth - 1, currentAlpha, currentBeta);
-				_pos->undoMove();
-				if (s > score) {
-					score = s;
-					if (score > currentAlpha) {
-						currentAlpha = score;
-					}
-					if (score >= currentBeta) {
-						break;
-					}
+	uint16_t legalMoveCount = 0;
+	bool inCheck = _pos->kingUnderCheck();
+	// The fifty move rule draws in check if there is any legal move
+	bool fiftyMoveDraw = inCheck && _pos->fiftyMoveRuleReached();
+	// Quite moves which did not cause beta cutoff
+	MoveInfo quiteMoves[MAX_POSSIBLE_MOVES];
+	uint16_t quiteMovesSize = 0;
+	while(generatedMove.from != INVALID_SQUARE) {
+		MoveGenerationStage stage = _moveGen->currentStage();
+		if (_pos->pseudoMoveIsLegalMove(generatedMove)) {
+			++legalMoveCount;
+			if (fiftyMoveDraw) {
+				break;
+			}
+			// Only the late quite moves which do not check are reduced or pruned,
+			// captures, killers and the evasions are searched to the full depth,
+			// the pruned moves are not made
+			bool isLateQuiteMove = stage == QUITE_MOVES && !inCheck && isQuietMove(generatedMove) &&
+				legalMoveCount > 1 && !_pos->moveGivesCheck(generatedMove);
+			if (isLateQuiteMove && !isPVNode && depth <= LMP_MAX_DEPTH &&
+					legalMoveCount > LATE_MOVE_COUNT[depth] && score > -MAX_SCORE) {
+				generatedMove = _moveGen->getTopMove(*_pos, depth);
+				continue;
+			}
+			prefetchChild(generatedMove, depth == 1);
+			_pos->makeMove(generatedMove);
+
+			int16_t s;
+			if (legalMoveCount == 1) {
+				s = -alphaBeta(depth - 1, ply + 1, -beta, -currentAlpha);
+			}
+			else {
+				uint16_t reduction = 0;
+				if (isLateQuiteMove && depth >= LMR_MIN_DEPTH) {
+					reduction = lateMoveReduction(depth, legalMoveCount, isPVNode);
+				}
+				// Zero window search proves that the move is not better
+				// than the best one, the move is searched again with
+				// the full depth and then with the full window only
+				// if the proof fails
+				s = -alphaBeta(depth - 1 - reduction, ply + 1, -currentAlpha - 1, -currentAlpha);
+				if (reduction && s > currentAlpha) {
+					s = -alphaBeta(depth - 1, ply + 1, -currentAlpha - 1, -currentAlpha);
+				}
+				if (s > currentAlpha && s < beta) {
+					s = -alphaBeta(depth - 1, ply + 1, -beta, -currentAlpha);
 				}
-				_pos->updateCheckPinInfo(depth);
 			}
-			generatedMove = _moveGen->getTopMove(*_pos, depth);
-		}
-	}
-	else {
-		score = MAX_SCORE;
-		while(generatedMove.from != INVALID_SQUARE) {
-			if (_pos->pseudoMoveIsLegalMove(generatedMove)) {
-				_pos->makeMove(generatedMove);
-				int16_t s = alphaBeta(depth - 1, currentAlpha, currentBeta);
-				_pos->undoMove();
-				if (s < score) {
-					score = s;
-					if (score < currentBeta) {
-						currentBeta = score;
+			_pos->undoMove();
+			if (_stopped) {
+				return 0;
+			}
+			if (s > score) {
+				score = s;
+				bestMove = generatedMove;
+				if (score > currentAlpha) {
+					currentAlpha = score;
+					if (isPVNode) {
+						updatePV(ply, generatedMove);
 					}
-					if (score <= currentAlpha) {
-						break;
+				}
+				if (score >= beta) {
+					STATS_INCR(betaCutoffs[stage]);
+					if (legalMoveCount == 1) {
+						STATS_INCR(firstMoveCutoffs);
+					}
+					if (isQuietMove(generatedMove)) {
+						_moveGen->updateQuiteMoveHeuristics(*_pos, generatedMove, depth, ply, quiteMoves, quiteMovesSize);
 					}
+					break;
 				}
-				_pos->updateCheckPinInfo(depth);
 			}
-			generatedMove = _moveGen->getTopMove(*_pos, depth);
+			if (isQuietMove(generatedMove) && quiteMovesSize < MAX_POSSIBLE_MOVES) {
+				quiteMoves[quiteMovesSize++] = generatedMove;
+			}
+			_pos->updateCheckPinInfo(depth);
 		}
+		generatedMove = _moveGen->getTopMove(*_pos, depth);
+	}
+
+	if (legalMoveCount == 0) {
+		score = inCheck ? -MAX_SCORE + ply : DRAW_SCORE;
+	}
+	else if (fiftyMoveDraw) {
+		// the draw depends on the halfmove clock,
+		// so it is not stored in the transposition table
+		return DRAW_SCORE;
 	}
 	
-	if (score > alpha && score < beta) {
-		eval.posValue = score;
-		eval.zobKey = _pos->getZobKey();
-		eval.depth = depth;
-		_transTable->forcePush(eval);
+	BoundType bound = scoreBound(score, alpha, beta);
+	// Moves of the nodes where all the moves failed low are not reliable,
+	// so the previously stored move is kept for them
+	if (bound != UPPER_BOUND) {
+		eval.move = bestMove;
 	}
+	eval = EvalInfo(scoreToTT(score, ply), _pos->getZobKey(), depth, bound, eval.move);
+	_transTable->forcePush(eval);
 
 	return score;
 }
 
-int16_t ABCore::quiescenceSearch(int16_t qsDepth, int16_t alpha, int16_t beta)
+// Null move is not tried in check, after another null move and if the
+// side to move has only pawns (zugzwang is likely), the depth reduction
+// is 2 or 3 (for the deeper searches) plus depth / 6
+bool ABCore::nullMoveCutoff(uint16_t depth, uint16_t ply, int16_t beta, int16_t& score)
+{
+	if (depth < NULL_MOVE_MIN_DEPTH || ply < _nullMoveMinPly || _pos->kingUnderCheck() ||
+			_pos->lastMoveIsNull() || _pos->sideToMoveHasOnlyPawns() ||
+			isMateScore(beta) || staticEval() < beta) {
+		return false;
+	}
+
+	uint16_t reduction = (depth > 6 ? 3 : 2) + depth / 6;
+	uint16_t nullDepth = depth > reduction ? depth - reduction - 1 : 0;
+	_pos->makeNullMove();
+	score = -alphaBeta(nullDepth, ply + 1, -beta, -beta + 1);
+	_pos->undoNullMove();
+	if (_stopped || score < beta) {
+		return false;
+	}
+
+	// Mate scores of the null move search are not reliable
+	if (score >= MATE_BOUND) {
+		score = beta;
+	}
+
+	if (depth < NULL_MOVE_VERIFICATION_DEPTH) {
+		return true;
+	}
+
+	// Verification search without null moves for the
+	// first plies of the subtree detects zugzwangs
+	uint16_t nullMoveMinPly = _nullMoveMinPly;
+	_nullMoveMinPly = ply + 3 * nullDepth / 4 + 1;
+	int16_t verifiedScore = alphaBeta(nullDepth, ply, beta - 1, beta);
+	_nullMoveMinPly = nullMoveMinPly;
+
+	return !_stopped && verifiedScore >= beta;
+}
+
+void ABCore::initLateMoveReductions()
+{
+	for (int depth = 0; depth < MAX_SEARCH_DEPTH; ++depth) {
+		for (int moveCount = 0; moveCount < MAX_POSSIBLE_MOVES; ++moveCount) {
+			double reduction = depth && moveCount ? std::log((double) depth) * std::log((double) moveCount) / LMR_DIVISOR : 0;
+			_lateMoveReductions[depth][moveCount] = (uint8_t) reduction;
+		}
+	}
+}
+
+// The reduction leaves at least one ply for the move,
+// moves of PV nodes are reduced one ply less
+uint16_t ABCore::lateMoveReduction(uint16_t depth, uint16_t moveCount, bool isPVNode) const
 {
+	uint16_t reduction = _lateMoveReductions[depth < MAX_SEARCH_DEPTH ? depth : MAX_SEARCH_DEPTH - 1]
+		[moveCount < MAX_POSSIBLE_MOVES ? moveCount : MAX_POSSIBLE_MOVES - 1];
+	if (isPVNode && reduction) {
+		--reduction;
+	}
+	if (reduction > depth - 2) {
+		reduction = depth - 2;
+	}
+
+	return reduction;
+}
+
+void ABCore::prefetchChild(const MoveInfo& move, bool evaluated) const
+{
+	ZobKey zobKey;
+	ZobKey pawnKey;
+	_pos->keysAfterMove(move, zobKey, pawnKey);
+	_transTable->prefetch(zobKey);
+	if (evaluated) {
+		_posEval->prefetch(zobKey, pawnKey);
+	}
+}
+
+int16_t ABCore::staticEval(int16_t alpha, int16_t beta) const
+{
+	if (_pos->whiteToPlay()) {
+		return _posEval->evaluate(*_pos, alpha, beta);
+	}
+	return -_posEval->evaluate(*_pos, -beta, -alpha);
+}
+
+int16_t ABCore::quiescenceSearch(int16_t qsDepth, uint16_t ply, int16_t alpha, int16_t beta)
+{
+	countNode();
+	if (ply > _selDepth) {
+		_selDepth = ply;
+	}
+	if (searchIsStopped()) {
+		return 0;
+	}
+	STATS_INCR(qsearchNodes);
 	EvalInfo eval;
-	int16_t val;
+	STATS_INCR(ttProbes[0]);
 	if (_transTable->contains(*_pos, eval)) {
-	   if (eval.depth > 0) {
-		   return eval.posValue;
-	   }
-	   else {
-		   val = eval.posValue;
-	   }
-	}
-	else {
-		val = _posEval->evaluate(*_pos);
-		eval.posValue = val;
-		eval.zobKey = _pos->getZobKey();
-		eval.depth = 0;
-		_transTable->forcePush(eval);
+		STATS_INCR(ttHits[0]);
+		eval.posValue = scoreFromTT(eval.posValue, ply);
+		if (evalCutsWindow(eval, alpha, beta)) {
+			STATS_INCR(ttCutoffs[0]);
+			return eval.posValue;
+		}
 	}
+	// static evaluations are cached by the position evaluation,
+	// only the searched values are stored in the transposition table
+	int16_t val = staticEval(alpha, beta);
 
-	if (qsDepth == MAX_QUIESCENCE_DEPTH) {
+	if (qsDepth == MAX_QUIESCENCE_DEPTH || val >= beta) {
 		return val;
 	}
 
 	int16_t currentAlpha = alpha;
-	int16_t currentBeta = beta;
-	int16_t score;
-	if (_pos->whiteToPlay()) {
-		if (val >= currentBeta) {
-			return val;
-		}
-	
-		if (val > currentAlpha) {
-			currentAlpha = val;
-		}
-		_moveGen->prepareMoveGeneration(QUIESCENCE_SEARCH, MoveInfo(), qsDepth);
-		_pos->initCheckPinInfo(qsDepth, true);
-
-		MoveInfo generatedMove = _moveGen->getTopMove(*_pos, qsDepth, true);
-		while(generatedMove.from != INVALID_SQUARE) {
-			if (_pos->pseudoMoveIsLegalMove(generatedMove)) {
-				_pos->makeMove(generatedMove);
-				score = quiescenceSearch(qsDepth + 1, currentAlpha, currentBeta);
-				_pos->undoMove();
-				if (score > currentAlpha) {
-					currentAlpha = score;
-				}
-				if (score >= currentBeta) {
-					break;
-				}
-				_pos->updateCheckPinInfo(qsDepth, true);
-			}
-			generatedMove = _moveGen->getTopMove(*_pos, qsDepth, true);
-		}
-
-		return currentAlpha;
+	if (val > currentAlpha) {
+		currentAlpha = val;
 	}
-	else {
-		if (val <= currentAlpha) {
-			return val;
-		}
-	
-		if (val < currentBeta) {
-			currentBeta = val;
-		}
-		_moveGen->prepareMoveGeneration(QUIESCENCE_SEARCH, MoveInfo(), qsDepth);
-		_pos->initCheckPinInfo(qsDepth, true);
+	_moveGen->prepareMoveGeneration(QUIESCENCE_SEARCH, MoveInfo(), qsDepth);
+	_pos->initCheckPinInfo(qsDepth, true);
 
-		MoveInfo generatedMove = _moveGen->getTopMove(*_pos, qsDepth, true);
-		int16_t score;
-		while(generatedMove.from != INVALID_SQUARE) {
-			if (_pos->pseudoMoveIsLegalMove(generatedMove)) {
-				_pos->makeMove(generatedMove);
-				score = quiescenceSearch(qsDepth + 1, currentAlpha, currentBeta);
-				_pos->undoMove();
-				if (score < currentBeta) {
-					currentBeta = score;
-				}
-				if (score <= currentAlpha) {
-					break;
-				}
-				_pos->updateCheckPinInfo(qsDepth, true);
+	MoveInfo generatedMove = _moveGen->getTopMove(*_pos, qsDepth, true);
+	while(generatedMove.from != INVALID_SQUARE) {
+		if (_pos->pseudoMoveIsLegalMove(generatedMove)) {
+			prefetchChild(generatedMove, true);
+			_pos->makeMove(generatedMove);
+			int16_t score = -quiescenceSearch(qsDepth + 1, ply + 1, -beta, -currentAlpha);
+			_pos->undoMove();
+			if (_stopped) {
+				return 0;
+			}
+			if (score > currentAlpha) {
+				currentAlpha = score;
 			}
-			generatedMove = _moveGen->getTopMove(*_pos, qsDepth, true);
+			if (score >= beta) {
+				break;
+			}
+			_pos->updateCheckPinInfo(qsDepth, true);
 		}
-
-		return currentBeta;
+		generatedMove = _moveGen->getTopMove(*_pos, qsDepth, true);
 	}
+
+	return currentAlpha;
 }
 
 ABCore::ABCore() :
 _posEval(new PositionEvaluation()),
-_transTable(new TranspositionTable())
+_transTable(new TranspositionTable()),
+_ownsTransTable(true),
+_softTimeLimit(0),
+_infinite(false),
+_nodeLimit(0),
+_nodeCount(0),
+_selDepth(0),
+_printInfo(false),
+_nullMoveMinPly(0),
+_stopped(false),
+_helperPos(0),
+_helperStop(false)
 {
 	_posEval->initPosEval();
+	initLateMoveReductions();
+}
+
+ABCore::ABCore(TranspositionTable* transTable) :
+_posEval(new PositionEvaluation()),
+_transTable(transTable),
+_ownsTransTable(false),
+_softTimeLimit(0),
+_infinite(false),
+_nodeLimit(0),
+_nodeCount(0),
+_selDepth(0),
+_printInfo(false),
+_nullMoveMinPly(0),
+_stopped(false),
+_helperPos(new PositionState()),
+_helperStop(false)
+{
+	_posEval->initPosEval();
+	initLateMoveReductions();
 }
 
 ABCore::~ABCore()
 {
+	setThreadCount(1);
 	delete _posEval;
-	delete _transTable;
+	delete _helperPos;
+	if (_ownsTransTable) {
+		delete _transTable;
+	}
 }
 
 } 	
@@ -2,6 +2,10 @@
 #define ABCORE_H_
 
 #include "utils.h"
+#include "MemPool.h"
+#include <vector>
+#include <atomic>
+#include <chrono>
 
 namespace pismo
 {
@@ -17,23 +21,142 @@ const uint16_t MAX_TRY = 5;
 
 const uint16_t MAX_QUIESCENCE_DEPTH = 10;
 
+// Null move is tried only if the remaining depth is at least
+// NULL_MOVE_MIN_DEPTH, null move cutoffs are verified by the
+// reduced normal search if the depth is at least NULL_MOVE_VERIFICATION_DEPTH
+const uint16_t NULL_MOVE_MIN_DEPTH = 2;
+const uint16_t NULL_MOVE_VERIFICATION_DEPTH = 8;
+
+// Late quite moves are reduced by log(depth) * log(moveCount) / LMR_DIVISOR
+// plies if the remaining depth is at least LMR_MIN_DEPTH
+const uint16_t LMR_MIN_DEPTH = 3;
+const double LMR_DIVISOR = 2.0;
+
+// Late quite moves of non-PV nodes with the remaining depth not
+// bigger than LMP_MAX_DEPTH are pruned after LATE_MOVE_COUNT[depth] moves
+const uint16_t LMP_MAX_DEPTH = 3;
+const uint16_t LATE_MOVE_COUNT[LMP_MAX_DEPTH + 1] = {0, 5, 8, 13};
+
+const unsigned int MAX_THREAD_COUNT = 64;
+
+// Number of nodes searched between the checks of the stop flags,
+// should be a power of 2
+const uint64_t STOP_CHECK_NODE_COUNT = 1024;
+
+// The currently searched root move is reported only
+// after CURRMOVE_INFO_TIME milliseconds of the search
+const unsigned int CURRMOVE_INFO_TIME = 1000;
+
 class ABCore
 {
 public:
 	/** Returns the best move in current position.
+	 * The position is searched iteratively with increasing depth,
+	 * if the search is stopped the best move of the last finished
+	 * iteration is returned
 	 * pos - current position
-	 * depth - search depth
+	 * depth - maximum search depth
+	 * softTimeLimit - new iteration is not started after softTimeLimit
+	 * milliseconds from the search start (0 if there is no limit),
+	 * the hard limit is handled by the caller stopping the search
+	 * infinite - the search does not finish early on the found mate,
+	 * only the depth limit or the stop ends it
+	 * nodeLimit - the search is stopped after nodeLimit nodes of all
+	 * the threads (0 if there is no limit), the limit is checked every
+	 * STOP_CHECK_NODE_COUNT nodes of the main thread
 	 */
 
-	MoveInfo think(PositionState& pos, uint16_t depth);
+	MoveInfo think(PositionState& pos, uint16_t depth, unsigned int softTimeLimit = 0,
+			bool infinite = false, uint64_t nodeLimit = 0);
+
+	/* Sets the number of threads used by the search
+	 * (the main thread included). Helper threads search
+	 * their own copies of the position and share the
+	 * transposition table with the main thread (Lazy SMP)
+	 */
+	void setThreadCount(unsigned int threadCount);
+	unsigned int threadCount() const {return _helpers.size() + 1;}
+
+	// Number of nodes searched by all the threads during the last search
+	uint64_t nodeCount() const;
+
+	// Enables printing of UCI info lines after each finished iteration
+	// of the search and of the currently searched root move
+	void setInfoOutput(bool printInfo) {_printInfo = printInfo;}
+
+	// Reallocates the transposition table to have
+	// sizeMB megabytes, should not be called during the search
+	void setHashSize(unsigned int sizeMB);
+
+	// Removes all the entries of the transposition table
+	// should not be called during the search
+	void clearHash();
 
 	ABCore();
 	~ABCore();
 
 private:
-	int16_t alphaBetaIterative(uint16_t depth, int16_t alpha, int16_t beta);
-	int16_t alphaBeta(uint16_t depth, int16_t alpha, int16_t beta);
-	int16_t quiescenceSearch(int16_t qsDepth, int16_t alpha, int16_t beta);
+	// Constructs helper searcher which uses transTable
+	// of the main searcher
+	explicit ABCore(TranspositionTable* transTable);
+
+	// Searches the copy of the root position until it is done
+	// or is stopped by the main thread; runs in helper thread
+	void helperThink(uint16_t depth);
+
+	// Legal move of the root position with its score and the
+	// number of nodes of its subtree in the last iteration
+	struct RootMove
+	{
+		MoveInfo move;
+		int16_t score;
+		uint64_t nodeCount;
+	};
+
+	static bool rootMoveOrder(const RootMove& first, const RootMove& second);
+
+	MoveInfo iterativeDeepening(uint16_t depth);
+	void generateRootMoves();
+
+	// Searches the root moves with the window (alpha, beta)
+	// and sorts them for the next iteration, returns false if
+	// the search was stopped before all the moves were searched
+	bool searchRoot(uint16_t depth, int16_t alpha, int16_t beta, int16_t& score);
+
+	// Reads the stop flags and returns true if the search should be stopped
+	bool pollStop();
+	bool searchIsStopped();
+
+	// ply is the distance from the root position
+	int16_t alphaBeta(uint16_t depth, uint16_t ply, int16_t alpha, int16_t beta);
+	int16_t quiescenceSearch(int16_t qsDepth, uint16_t ply, int16_t alpha, int16_t beta);
+
+	// The node counter is read by the main thread while the
+	// helpers search, but only the owner thread changes it
+	void countNode() {_nodeCount.store(_nodeCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);}
+
+	// Sets the principal variation of ply to the move
+	// followed by the principal variation of the next ply
+	void updatePV(uint16_t ply, const MoveInfo& move);
+
+	// Milliseconds from the search start
+	uint64_t elapsedTime() const;
+	void printSearchInfo(uint16_t depth, int16_t score) const;
+
+	// Returns true if passing the move to the opponent in the
+	// current position still gives the score at least beta
+	bool nullMoveCutoff(uint16_t depth, uint16_t ply, int16_t beta, int16_t& score);
+
+	// Prefetches the transposition table bucket of the position after
+	// the move, and its evaluation hash entries if it will be evaluated
+	void prefetchChild(const MoveInfo& move, bool evaluated) const;
+
+	// Static evaluation relative to the side to move, the evaluation
+	// is lazy if it is outside (alpha, beta) by LAZY_EVAL_MARGIN
+	int16_t staticEval(int16_t alpha = -MAX_SCORE, int16_t beta = MAX_SCORE) const;
+
+	void initLateMoveReductions();
+	uint16_t lateMoveReduction(uint16_t depth, uint16_t moveCount, bool isPVNode) const;
 	
 
 	ABCore(const ABCore&); // non-copyable
@@ -44,6 +167,54 @@ private:
 	PositionEvaluation* _posEval;
 	TranspositionTable* _transTable;
 
+	// true if the transposition table is owned by the
+	// searcher, false for helpers
+	bool _ownsTransTable;
+
+	// Soft time limit of the search in milliseconds
+	// (0 if there is no limit) and the search start time
+	unsigned int _softTimeLimit;
+	std::chrono::steady_clock::time_point _startTime;
+	// The search is not finished early on the found mate
+	bool _infinite;
+	// Node limit of the search (0 if there is no limit), used only
+	// by the main searcher
+	uint64_t _nodeLimit;
+
+	// Root moves ordered by the last iteration
+	std::vector<RootMove> _rootMoves;
+
+	std::atomic<uint64_t> _nodeCount;
+
+	// Maximal ply reached by the search including the quiescence search
+	uint16_t _selDepth;
+
+	// Triangular table of the principal variations, the row
+	// of each ply holds the moves starting from the ply itself
+	MoveInfo _pvTable[MAX_SEARCH_DEPTH][MAX_SEARCH_DEPTH];
+	uint16_t _pvLength[MAX_SEARCH_DEPTH];
+
+	bool _printInfo;
+
+	// Null move is not allowed before this ply,
+	// used to verify null move cutoffs
+	uint16_t _nullMoveMinPly;
+
+	// Set when the stop flag is seen, results of the
+	// search after it are not used
+	bool _stopped;
+
+	// Late move reductions indexed by depth and move count
+	uint8_t _lateMoveReductions[MAX_SEARCH_DEPTH][MAX_POSSIBLE_MOVES];
+
+	// Helper searchers used by the main searcher
+	std::vector<ABCore*> _helpers;
+
+	// Helper searcher's own copy of the root position
+	PositionState* _helperPos;
+
+	// Set by the main searcher to stop the helper
+	std::atomic<bool> _helperStop;
 };
 
 }
@@ -1,5 +1,5 @@
 #include "BitboardImpl.h"
-#include "MagicMoves.h"
+#include "SliderAttacks.h"
 #include <assert.h>
 
 namespace pismo
@@ -87,7 +87,6 @@ Bitboard RankBitboard[RANKS_COUNT] =
 Bitboard KingZone[SQUARES_COUNT];
 
 
-const Bitboard BITSCAN_MAGIC = 0x07EDD5E59A4E28C2;
 
 BitboardImpl* BitboardImpl::_instance = 0;
 
@@ -106,9 +105,9 @@ void BitboardImpl::destroy()
 	_instance  = 0;
 }
 
-BitboardImpl::BitboardImpl()
+BitboardImpl::BitboardImpl() :
+_sliderAttacks(new SliderAttacks())
 {
-	initmagicmoves();
 	initBitScanTable();
 
 	initMovePosBoardKnight();
@@ -279,45 +278,45 @@ Bitboard BitboardImpl::pawnBlackMovesTo(Square to, const Bitboard& occupiedSquar
 }
 
 // Returns bitboard of possible rook moves from square from when 
-// occupiedSquares shows the occupancy. Uses magic bitboards for evaluation.
+// occupiedSquares shows the occupancy. Uses the slider attacks backend.
 Bitboard BitboardImpl::rookAttackFrom(Square from, const Bitboard& occupiedSquares) const
 {
-	return Rmagic(from, occupiedSquares);
+	return _sliderAttacks->rookAttacks(from, occupiedSquares);
 }
 
 // Returns bitboard of positions of the rooks which attack the square to
 // occupiedSquares shows the occupancy, rooksPos shows all the rook positions of appropriate color 
 Bitboard BitboardImpl::rooksAttackTo(Square to, const Bitboard& occupiedSquares, const Bitboard& rooksPos) const
 {
-	return Rmagic(to, occupiedSquares) & rooksPos;
+	return _sliderAttacks->rookAttacks(to, occupiedSquares) & rooksPos;
 }
 
 // Returns bitboard of possible bishop moves from square from when 
-// occupiedSquares shows the occupancy. Uses magic bitboards for evaluation.
+// occupiedSquares shows the occupancy. Uses the slider attacks backend.
 Bitboard BitboardImpl::bishopAttackFrom(Square from, const Bitboard& occupiedSquares) const
 {
-	return Bmagic(from, occupiedSquares);
+	return _sliderAttacks->bishopAttacks(from, occupiedSquares);
 }
 
 // Returns bitboard of positions of the bishops which attack the square to
 // occupiedSquares shows the occupancy, bishopsPos shows all the bishop positions of appropriate color 
 Bitboard BitboardImpl::bishopsAttackTo(Square to, const Bitboard& occupiedSquares, const Bitboard& bishopsPos) const
 {
-	return Bmagic(to, occupiedSquares) & bishopsPos;
+	return _sliderAttacks->bishopAttacks(to, occupiedSquares) & bishopsPos;
 }
 
 // Returns bitboard of possible queen moves from square from when 
-// occupiedSquares shows the occupancy. Uses magic bitboards for evluation.
+// occupiedSquares shows the occupancy. Uses the slider attacks backend.
 Bitboard BitboardImpl::queenAttackFrom(Square from, const Bitboard& occupiedSquares) const
 {
-	return Qmagic(from, occupiedSquares);
+	return _sliderAttacks->rookAttacks(from, occupiedSquares) | _sliderAttacks->bishopAttacks(from, occupiedSquares);
 }
 
 // Returns bitboard of positions of the queens which attack the square to
 // occupiedSquares shows the occupancy, queensPos shows all the queen positions of appropriate color 
 Bitboard BitboardImpl::queensAttackTo(Square to, const Bitboard& occupiedSquares, const Bitboard& queensPos) const
 {
-	return Qmagic(to, occupiedSquares) & queensPos;
+	return (_sliderAttacks->rookAttacks(to, occupiedSquares) | _sliderAttacks->bishopAttacks(to, occupiedSquares)) & queensPos;
 }
 
 // Changes the values of leftPos and rightPos to the squares where sliding piece and the king can be located
@@ -352,17 +351,6 @@ Bitboard BitboardImpl::getSquaresBetween(Square from, Square kingSq) const
 	return _squaresBetween[from][kingSq];
 }
 
-// Returns the least significant set bit position in the board
-// -1 if board is 0
-int BitboardImpl::lsb(const Bitboard& board) const
-{
-	if (board) {
-		return _bitScanTable[((board & (-board)) * BITSCAN_MAGIC) >> 58];
-	}
-	
-	return -1;
-}
-
 // Initializes knight movement position bitboard array for all squares
 void BitboardImpl::initMovePosBoardKnight()
 {
@@ -534,5 +522,6 @@ int BitboardImpl::msb(Bitrank rank) const
 
 BitboardImpl::~BitboardImpl()
 {
+	delete _sliderAttacks;
 }
 }
@@ -8,6 +8,10 @@ namespace pismo
 
 typedef uint8_t Bitrank;
 
+class SliderAttacks;
+
+const Bitboard BITSCAN_MAGIC = 0x07EDD5E59A4E28C2; // de Bruijn sequence for the bit scan table
+
 const Bitboard WHITE_SQUARES_MASK = 0x55AA55AA55AA55AA; // Bitboard of white squares
 const Bitboard BLACK_SQUARES_MASK = 0xAA55AA55AA55AA55; // Bitboard of black squares
 
@@ -140,7 +144,20 @@ public:
 
 	Bitboard getSquaresBetween(Square from, Square kingSq) const;
 
-	int lsb(const Bitboard& board) const;
+	// Returns the least significant set bit position in the board
+	// -1 if board is 0, tzcnt (or bsf) is used by the GCC builds
+	int lsb(const Bitboard& board) const
+	{
+		if (board) {
+#ifdef __GNUC__
+			return __builtin_ctzll(board);
+#else
+			return _bitScanTable[((board & (-board)) * BITSCAN_MAGIC) >> 58];
+#endif
+		}
+
+		return -1;
+	}
 
 //private member functions
 private:
@@ -167,6 +184,9 @@ private:
 private:
 	static BitboardImpl* _instance;
 
+	// Rook and bishop attacks of the backend chosen at build time
+	SliderAttacks* _sliderAttacks;
+
 	Bitboard _movePosBoardKnight[SQUARES_COUNT];
 	Bitboard _movePosBoardKing[SQUARES_COUNT];
 	Bitboard _attackingPosBoardPawnWhite[SQUARES_COUNT - 16];
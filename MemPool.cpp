@@ -4,11 +4,12 @@
 namespace pismo
 {
 
-MoveGenInfo* g_moveGenInfo[MAX_SEARCH_DEPTH];
-MoveGenInfo* g_quiescenceMoveGenInfo[MAX_QUIESCENCE_SEARCH_DEPTH];
+// Each search thread has its own memory pool
+thread_local MoveGenInfo* g_moveGenInfo[MAX_SEARCH_DEPTH];
+thread_local MoveGenInfo* g_quiescenceMoveGenInfo[MAX_QUIESCENCE_SEARCH_DEPTH];
 
-CheckPinInfo* g_checkPinInfo[MAX_SEARCH_DEPTH];
-CheckPinInfo* g_quiescenceCheckPinInfo[MAX_QUIESCENCE_SEARCH_DEPTH];
+thread_local CheckPinInfo* g_checkPinInfo[MAX_SEARCH_DEPTH];
+thread_local CheckPinInfo* g_quiescenceCheckPinInfo[MAX_QUIESCENCE_SEARCH_DEPTH];
 
 void MemPool::initMoveGenInfo() 
 {
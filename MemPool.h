@@ -7,6 +7,8 @@ namespace pismo
 {
 
 //reusing allocated memory to avoid wasting time on system calls (free(), alloc())
+//the memory pool is thread local, so each thread which uses move generation
+//or check and pin info should initialize (and destroy) its own pool
 
 
 //maximum number of moves one side can have in current position
@@ -16,6 +18,9 @@ const int MAX_POSSIBLE_MOVES = 100;
 const int MAX_SEARCH_DEPTH = 60;
 const int MAX_QUIESCENCE_SEARCH_DEPTH = 10;
 
+//killer moves of the ply and the countermove
+const int MAX_KILLER_STAGE_MOVES = 3;
+
 struct MoveGenInfo
 {
 	MoveInfo _availableMoves[MAX_POSSIBLE_MOVES];
@@ -23,8 +28,15 @@ struct MoveGenInfo
 	uint16_t _badCaptureSize;
 	uint16_t _availableMovesSize;
 	MoveGenerationStage _nextStage;
+	// Stage of the last returned move
+	MoveGenerationStage _currentStage;
 	SearchType _searchType;
 	MoveInfo _cachedMove;
+	uint16_t _ply;
+	// Moves returned in killer moves stage, which
+	// are skipped in quite moves stage
+	MoveInfo _killerMoves[MAX_KILLER_STAGE_MOVES];
+	uint16_t _killerMovesSize;
 };
 
 struct CheckPinInfo
@@ -2,14 +2,16 @@
 #include "PositionState.h"
 #include "BitboardImpl.h"
 #include "MemPool.h"
+#include "SearchStats.h"
 
 #include <assert.h>
 #include <algorithm>
+#include <cstdlib>
 
 namespace pismo
 {
 
-MoveGenerator* MoveGenerator::_instance = 0;
+thread_local MoveGenerator* MoveGenerator::_instance = 0;
 
 MoveGenerator* MoveGenerator::instance()
 {
@@ -30,14 +32,75 @@ MoveGenerator::MoveGenerator() :
 	_bitboardImpl(BitboardImpl::instance()),
 	_gainSEE(new int32_t[MAX_SEARCH_DEPTH])
 {
+	for (int i = 0; i < PIECE_COUNT; ++i) {
+		for (int j = 0; j < SQUARES_COUNT; ++j) {
+			_history[i][j] = 0;
+			_counterMoves[i][j] = MoveInfo();
+		}
+	}
+	resetMoveHeuristics();
+}
+
+void MoveGenerator::resetMoveHeuristics()
+{
+	for (int i = 0; i < MAX_SEARCH_PLY; ++i) {
+		for (int j = 0; j < KILLER_MOVES_PER_PLY; ++j) {
+			_killerMoves[i][j] = MoveInfo();
+		}
+	}
+
+	// history of the previous search is still useful,
+	// but should be outweighed by the new one
+	for (int i = 0; i < PIECE_COUNT; ++i) {
+		for (int j = 0; j < SQUARES_COUNT; ++j) {
+			_history[i][j] /= 2;
+		}
+	}
+}
+
+void MoveGenerator::updateQuiteMoveHeuristics(const PositionState& pos, const MoveInfo& move, uint16_t depth, uint16_t ply,
+		const MoveInfo* failedMoves, uint16_t failedMovesSize)
+{
+	if (ply < MAX_SEARCH_PLY && !equal(_killerMoves[ply][0], move)) {
+		for (int i = KILLER_MOVES_PER_PLY - 1; i > 0; --i) {
+			_killerMoves[ply][i] = _killerMoves[ply][i - 1];
+		}
+		_killerMoves[ply][0] = move;
+	}
 
+	MoveInfo previousMove = pos.lastMove();
+	if (previousMove.from != INVALID_SQUARE) {
+		Piece previousPiece = pos.getBoard()[mRank(previousMove.to)][mFile(previousMove.to)];
+		_counterMoves[previousPiece][previousMove.to] = move;
+	}
+
+	int bonus = depth * depth;
+	updateHistory(_history[pos.getBoard()[mRank(move.from)][mFile(move.from)]][move.to], bonus);
+	for (uint16_t i = 0; i < failedMovesSize; ++i) {
+		updateHistory(_history[pos.getBoard()[mRank(failedMoves[i].from)][mFile(failedMoves[i].from)]][failedMoves[i].to], -bonus);
+	}
 }
 
-void MoveGenerator::prepareMoveGeneration(SearchType type, const MoveInfo& transTableMove, uint16_t depth)	
+// Moves the history towards the bonus sign, so that
+// the value never leaves [-HISTORY_MAX, HISTORY_MAX] range
+void MoveGenerator::updateHistory(int16_t& history, int bonus)
+{
+	if (bonus > HISTORY_MAX) {
+		bonus = HISTORY_MAX;
+	}
+	else if (bonus < -HISTORY_MAX) {
+		bonus = -HISTORY_MAX;
+	}
+	history += bonus - history * std::abs(bonus) / HISTORY_MAX;
+}
+
+void MoveGenerator::prepareMoveGeneration(SearchType type, const MoveInfo& transTableMove, uint16_t depth, uint16_t ply)	
 {
 	_moveGenInfo = type != QUIESCENCE_SEARCH ? MemPool::getMoveGenInfo(depth) : MemPool::getQuiescenceMoveGenInfo(depth);
 	_moveGenInfo->_searchType = type;
 	_moveGenInfo->_cachedMove = transTableMove; 
+	_moveGenInfo->_ply = ply;
+	_moveGenInfo->_killerMovesSize = 0;
 	switch (_moveGenInfo->_searchType) {
 		case USUAL_SEARCH:
 			_moveGenInfo->_nextStage = GOOD_CAPTURING_MOVES;
@@ -51,6 +114,9 @@ void MoveGenerator::prepareMoveGeneration(SearchType type, const MoveInfo& trans
 		default:
 			assert(false);
 	}
+	if (type != QUIESCENCE_SEARCH && transTableMove.from != INVALID_SQUARE) {
+		_moveGenInfo->_nextStage = TRANS_TABLE_MOVE;
+	}
 	_moveGenInfo->_currentMovePos = 0;
 	_moveGenInfo->_badCaptureSize = 0;
 	_moveGenInfo->_availableMovesSize = 0;
@@ -75,6 +141,167 @@ void MoveGenerator::generatePerftMoves(const PositionState& pos, uint16_t depth)
   }
 }
 
+uint16_t MoveGenerator::generateStageMoves(const PositionState& pos, uint16_t depth, MoveGenerationStage stage)
+{
+	_positionState = &pos;
+	_moveGenInfo = MemPool::getMoveGenInfo(depth);
+	_checkPinInfo = MemPool::getCheckPinInfo(depth);
+	_moveGenInfo->_currentMovePos = 0;
+	_moveGenInfo->_availableMovesSize = 0;
+
+	switch (stage) {
+		case GOOD_CAPTURING_MOVES:
+			generateCapturingMoves();
+			break;
+		case CHECKING_MOVES:
+			generateCheckingMoves();
+			break;
+		case QUITE_MOVES:
+			generateQuiteMoves();
+			break;
+		case EVASION_MOVES:
+			generateEvasionMoves();
+			break;
+		default:
+			assert(false);
+	}
+
+	return _moveGenInfo->_availableMovesSize;
+}
+
+int16_t MoveGenerator::staticExchangeEval(const PositionState& pos, const MoveInfo& move)
+{
+	_positionState = &pos;
+	return SEE(move);
+}
+
+POPCNT_CLONES
+uint16_t MoveGenerator::countPerftMoves(const PositionState& pos, uint16_t depth)
+{
+	_positionState = &pos;
+	_moveGenInfo = MemPool::getMoveGenInfo(depth);
+	_checkPinInfo = MemPool::getCheckPinInfo(depth);
+	_moveGenInfo->_currentMovePos = 0;
+	_moveGenInfo->_availableMovesSize = 0;
+
+	bool whiteToPlay = pos.whiteToPlay();
+	Square kingSq = whiteToPlay ? pos.whiteKingPosition() : pos.blackKingPosition();
+	// King moves, en passant captures and the moves of pinned
+	// pieces are generated and checked for legality
+	generateKingCapturingMoves(kingSq);
+	if (whiteToPlay) {
+		generateKingWhiteQuiteMoves(kingSq);
+	}
+	else {
+		generateKingBlackQuiteMoves(kingSq);
+	}
+
+	uint16_t moveCount = 0;
+	if (!pos.isDoubleCheck()) {
+		Bitboard ownPieces = whiteToPlay ? pos.whitePieces() : pos.blackPieces();
+		Bitboard opponentPieces = whiteToPlay ? pos.blackPieces() : pos.whitePieces();
+		Bitboard occupiedSquares = pos.occupiedSquares();
+		// Under check the moves should capture the checking
+		// piece or interpose it
+		Bitboard targets = pos.kingUnderCheck() ? pos.absolutePinsPos() : ~ownPieces;
+		Bitboard pinnedPieces = _checkPinInfo->_pinPiecePos;
+
+		Bitboard pawnsPos = pos._piecePos[whiteToPlay ? PAWN_WHITE : PAWN_BLACK];
+		while (pawnsPos) {
+			Square from = (Square) _bitboardImpl->lsb(pawnsPos);
+			if (squareToBitboard[from] & pinnedPieces) {
+				if (whiteToPlay) {
+					generatePawnWhiteCapturingMoves(from);
+					generatePawnWhiteQuiteMoves(from);
+				}
+				else {
+					generatePawnBlackCapturingMoves(from);
+					generatePawnBlackQuiteMoves(from);
+				}
+			}
+			else {
+				Bitboard moveBoard = whiteToPlay ?
+					(_bitboardImpl->pawnWhiteAttackFrom(from) & opponentPieces) | _bitboardImpl->pawnWhiteMovesFrom(from, occupiedSquares) :
+					(_bitboardImpl->pawnBlackAttackFrom(from) & opponentPieces) | _bitboardImpl->pawnBlackMovesFrom(from, occupiedSquares);
+				moveBoard &= targets;
+				if (moveBoard) {
+					int count = bitCount(moveBoard);
+					// each promotion is counted for all four pieces
+					moveCount += (whiteToPlay ? from >= A7 : from <= H2) ? 4 * count : count;
+				}
+
+				Square enPassantTarget = pos.enPassantTarget();
+				Bitboard attackBoard = whiteToPlay ? _bitboardImpl->pawnWhiteAttackFrom(from) : _bitboardImpl->pawnBlackAttackFrom(from);
+				if (enPassantTarget != INVALID_SQUARE && (attackBoard & squareToBitboard[enPassantTarget])) {
+					(_moveGenInfo->_availableMoves)[(_moveGenInfo->_availableMovesSize)++] = MoveInfo(from, enPassantTarget, ETY_SQUARE, EN_PASSANT_CAPTURE, 0);
+				}
+			}
+			pawnsPos &= (pawnsPos - 1);
+		}
+
+		Bitboard knightsPos = pos._piecePos[whiteToPlay ? KNIGHT_WHITE : KNIGHT_BLACK];
+		while (knightsPos) {
+			Square from = (Square) _bitboardImpl->lsb(knightsPos);
+			// pinned knight can not move
+			if (!(squareToBitboard[from] & pinnedPieces)) {
+				Bitboard moveBoard = _bitboardImpl->knightAttackFrom(from) & ~ownPieces & targets;
+				moveCount += moveBoard ? bitCount(moveBoard) : 0;
+			}
+			knightsPos &= (knightsPos - 1);
+		}
+
+		Bitboard bishopsPos = pos._piecePos[whiteToPlay ? BISHOP_WHITE : BISHOP_BLACK];
+		while (bishopsPos) {
+			Square from = (Square) _bitboardImpl->lsb(bishopsPos);
+			if (squareToBitboard[from] & pinnedPieces) {
+				generateBishopCapturingMoves(from);
+				generateBishopQuiteMoves(from);
+			}
+			else {
+				Bitboard moveBoard = _bitboardImpl->bishopAttackFrom(from, occupiedSquares) & ~ownPieces & targets;
+				moveCount += moveBoard ? bitCount(moveBoard) : 0;
+			}
+			bishopsPos &= (bishopsPos - 1);
+		}
+
+		Bitboard rooksPos = pos._piecePos[whiteToPlay ? ROOK_WHITE : ROOK_BLACK];
+		while (rooksPos) {
+			Square from = (Square) _bitboardImpl->lsb(rooksPos);
+			if (squareToBitboard[from] & pinnedPieces) {
+				generateRookCapturingMoves(from);
+				generateRookQuiteMoves(from);
+			}
+			else {
+				Bitboard moveBoard = _bitboardImpl->rookAttackFrom(from, occupiedSquares) & ~ownPieces & targets;
+				moveCount += moveBoard ? bitCount(moveBoard) : 0;
+			}
+			rooksPos &= (rooksPos - 1);
+		}
+
+		Bitboard queensPos = pos._piecePos[whiteToPlay ? QUEEN_WHITE : QUEEN_BLACK];
+		while (queensPos) {
+			Square from = (Square) _bitboardImpl->lsb(queensPos);
+			if (squareToBitboard[from] & pinnedPieces) {
+				generateQueenCapturingMoves(from);
+				generateQueenQuiteMoves(from);
+			}
+			else {
+				Bitboard moveBoard = _bitboardImpl->queenAttackFrom(from, occupiedSquares) & ~ownPieces & targets;
+				moveCount += moveBoard ? bitCount(moveBoard) : 0;
+			}
+			queensPos &= (queensPos - 1);
+		}
+	}
+
+	for (uint16_t i = 0; i < _moveGenInfo->_availableMovesSize; ++i) {
+		if (pos.pseudoMoveIsLegalMove((_moveGenInfo->_availableMoves)[i])) {
+			++moveCount;
+		}
+	}
+
+	return moveCount;
+}
+
 MoveInfo MoveGenerator::getTopMove(const PositionState& pos, uint16_t depth, bool isQuiescenceSearch)
 {
 	if (!isQuiescenceSearch) {
@@ -87,11 +314,32 @@ MoveInfo MoveGenerator::getTopMove(const PositionState& pos, uint16_t depth, boo
 	}
 	assert(_moveGenInfo);
 	_positionState = &pos;
-	if (_moveGenInfo->_currentMovePos < _moveGenInfo->_availableMovesSize && 
-			equal((_moveGenInfo->_availableMoves)[_moveGenInfo->_currentMovePos], _moveGenInfo->_cachedMove)) {
-		++(_moveGenInfo->_currentMovePos);
+	if (_moveGenInfo->_nextStage == TRANS_TABLE_MOVE) {
+		// The transposition table move is tried before generating
+		// any move, it is skipped in the later stages
+		_moveGenInfo->_nextStage = _moveGenInfo->_searchType == EVASION_SEARCH ? EVASION_MOVES : GOOD_CAPTURING_MOVES;
+		_moveGenInfo->_currentStage = TRANS_TABLE_MOVE;
+		if (pos.moveIsPseudoLegal(_moveGenInfo->_cachedMove)) {
+			return _moveGenInfo->_cachedMove;
+		}
+		if (_moveGenInfo->_cachedMove.from != INVALID_SQUARE) {
+			STATS_INCR(ttMoveCollisions);
+		}
+		_moveGenInfo->_cachedMove = MoveInfo();
 	}
-	if (_moveGenInfo->_currentMovePos == _moveGenInfo->_availableMovesSize) {
+
+	while (true) {
+		while (_moveGenInfo->_currentMovePos < _moveGenInfo->_availableMovesSize) {
+			const MoveInfo& move = (_moveGenInfo->_availableMoves)[(_moveGenInfo->_currentMovePos)++];
+			if (!equal(move, _moveGenInfo->_cachedMove)) {
+				return move;
+			}
+		}
+
+		if (_moveGenInfo->_nextStage == SEARCH_FINISHED) {
+			return MoveInfo();
+		}
+
 		switch(_moveGenInfo->_searchType) {
 			case USUAL_SEARCH:
 				generateMovesForUsualSearch();
@@ -104,12 +352,11 @@ MoveInfo MoveGenerator::getTopMove(const PositionState& pos, uint16_t depth, boo
 				break;
 		}
 	}
+}
 
-	if ( _moveGenInfo->_currentMovePos < _moveGenInfo->_availableMovesSize) {
-		return (_moveGenInfo->_availableMoves)[(_moveGenInfo->_currentMovePos)++];
-	}
-
-	return MoveInfo();
+MoveGenerationStage MoveGenerator::currentStage() const
+{
+	return _moveGenInfo->_currentStage;
 }
 
 bool MoveGenerator::equal(const MoveInfo& first, const MoveInfo& second) const
@@ -121,13 +368,22 @@ void MoveGenerator::generateMovesForUsualSearch()
 {
 	switch(_moveGenInfo->_nextStage) {
 		case GOOD_CAPTURING_MOVES:
+			_moveGenInfo->_currentStage = GOOD_CAPTURING_MOVES;
 			generateCapturingMoves();
 			sortGoodCapturingMoves();
+			_moveGenInfo->_nextStage = KILLER_MOVES;
+			if (_moveGenInfo->_currentMovePos < _moveGenInfo->_availableMovesSize) {
+				break;
+			}
+		case KILLER_MOVES:
+			_moveGenInfo->_currentStage = KILLER_MOVES;
+			generateKillerMoves();
 			_moveGenInfo->_nextStage = QUITE_MOVES;
 			if (_moveGenInfo->_currentMovePos < _moveGenInfo->_availableMovesSize) {
 				break;
 			}
 		case QUITE_MOVES:
+			_moveGenInfo->_currentStage = QUITE_MOVES;
 			generateQuiteMoves();
 			sortQuiteMoves();
 			_moveGenInfo->_nextStage = BAD_CAPTURING_MOVES;
@@ -135,6 +391,7 @@ void MoveGenerator::generateMovesForUsualSearch()
 				break;
 			}
 		case BAD_CAPTURING_MOVES:
+			_moveGenInfo->_currentStage = BAD_CAPTURING_MOVES;
 			sortBadCapturingMoves();
 			_moveGenInfo->_nextStage = SEARCH_FINISHED;
 			if (_moveGenInfo->_currentMovePos < _moveGenInfo->_availableMovesSize) {
@@ -150,6 +407,7 @@ void MoveGenerator::generateMovesForEvasionSearch()
 {
 	switch(_moveGenInfo->_nextStage) {
 		case EVASION_MOVES:
+			_moveGenInfo->_currentStage = EVASION_MOVES;
 			generateEvasionMoves();
 			sortEvasionMoves();
 			_moveGenInfo->_nextStage = SEARCH_FINISHED;
@@ -166,6 +424,7 @@ void MoveGenerator::generateMovesForQuiescenceSearch()
 {
 	switch(_moveGenInfo->_nextStage) {
 		case GOOD_CAPTURING_MOVES:
+			_moveGenInfo->_currentStage = GOOD_CAPTURING_MOVES;
 			generateCapturingMoves();
 			sortGoodCapturingMoves();
 			_moveGenInfo->_nextStage = CHECKING_MOVES;
@@ -173,6 +432,7 @@ void MoveGenerator::generateMovesForQuiescenceSearch()
 				break;
 			}
 		case CHECKING_MOVES:
+			_moveGenInfo->_currentStage = CHECKING_MOVES;
 			generateCheckingMoves();
 			sortCheckingMoves();
 			_moveGenInfo->_nextStage = SEARCH_FINISHED;
@@ -1463,11 +1723,11 @@ void MoveGenerator::generateKingBlackQuiteMoves(Square from)
 }
 
 // Defines sorting order to be used in move sorting functions
-// returns true if the first moves value is bigger or equal
-// to second moves value
+// returns true if the first moves value is bigger
+// than second moves value (std::sort requires strict ordering)
 bool MoveGenerator::moveSortOrder(const MoveInfo& first, const MoveInfo& second)
 {
-	return first.value >= second.value;
+	return first.value > second.value;
 }
 
 // Divides all generated capturing moves into two sectors
@@ -1698,14 +1958,73 @@ void MoveGenerator::sortEvasionMoves()
 	std::sort(_moveGenInfo->_availableMoves + beginBadCapture, _moveGenInfo->_availableMoves + _moveGenInfo->_availableMovesSize, moveSortOrder);
 }
 
+// Removes the moves already returned in killer moves stage
+// and sorts the others by their history values
 void MoveGenerator::sortQuiteMoves()
 {
-	// TODO: Implement sorting quite moves based on history heuristic
+	uint16_t moveCount = _moveGenInfo->_currentMovePos;
+	while (moveCount < _moveGenInfo->_availableMovesSize) {
+		MoveInfo& move = _moveGenInfo->_availableMoves[moveCount];
+		bool isKillerMove = false;
+		for (uint16_t i = 0; i < _moveGenInfo->_killerMovesSize; ++i) {
+			if (equal(move, _moveGenInfo->_killerMoves[i])) {
+				isKillerMove = true;
+				break;
+			}
+		}
+		if (isKillerMove) {
+			move = _moveGenInfo->_availableMoves[--(_moveGenInfo->_availableMovesSize)];
+		}
+		else {
+			move.value = _history[_positionState->getBoard()[mRank(move.from)][mFile(move.from)]][move.to];
+			++moveCount;
+		}
+	}
+
+	std::sort(_moveGenInfo->_availableMoves + _moveGenInfo->_currentMovePos,
+		   	_moveGenInfo->_availableMoves + _moveGenInfo->_availableMovesSize, moveSortOrder);
+}
+
+// Killer moves are the quite moves which caused beta cutoff
+// in the same ply of the other positions, countermove is the
+// one which caused beta cutoff after the same previous move
+void MoveGenerator::generateKillerMoves()
+{
+	MoveInfo candidates[MAX_KILLER_STAGE_MOVES];
+	uint16_t candidatesSize = 0;
+	if (_moveGenInfo->_ply < MAX_SEARCH_PLY) {
+		for (int i = 0; i < KILLER_MOVES_PER_PLY; ++i) {
+			candidates[candidatesSize++] = _killerMoves[_moveGenInfo->_ply][i];
+		}
+	}
+	MoveInfo previousMove = _positionState->lastMove();
+	if (previousMove.from != INVALID_SQUARE) {
+		Piece previousPiece = _positionState->getBoard()[mRank(previousMove.to)][mFile(previousMove.to)];
+		candidates[candidatesSize++] = _counterMoves[previousPiece][previousMove.to];
+	}
+
+	for (uint16_t i = 0; i < candidatesSize; ++i) {
+		MoveInfo& move = candidates[i];
+		if (move.from == INVALID_SQUARE || equal(move, _moveGenInfo->_cachedMove)) {
+			continue;
+		}
+		bool isDuplicate = false;
+		for (uint16_t j = 0; j < _moveGenInfo->_killerMovesSize; ++j) {
+			if (equal(move, _moveGenInfo->_killerMoves[j])) {
+				isDuplicate = true;
+				break;
+			}
+		}
+		if (!isDuplicate && _positionState->moveIsPseudoLegal(move) && isQuietMove(move)) {
+			_moveGenInfo->_killerMoves[(_moveGenInfo->_killerMovesSize)++] = move;
+			(_moveGenInfo->_availableMoves)[(_moveGenInfo->_availableMovesSize)++] = move;
+		}
+	}
 }
 
 MoveGenerator::~MoveGenerator()
 {
-	delete _gainSEE;
+	delete[] _gainSEE;
 }
 
 }
@@ -6,6 +6,12 @@
 
 namespace pismo
 {
+const int KILLER_MOVES_PER_PLY = 2;
+const int MAX_SEARCH_PLY = 64;
+
+// History values are kept in [-HISTORY_MAX, HISTORY_MAX]
+const int HISTORY_MAX = 16000;
+
 class PositionState;
 class PossibleMoves;
 class BitboardImpl;
@@ -18,19 +24,56 @@ public:
 	static MoveGenerator* instance();
 	void destroy();
 
-	void prepareMoveGeneration(SearchType type, const MoveInfo& transTableMove, uint16_t depth);
+	// transTableMove (if valid) is returned by getTopMove before
+	// all the other moves, and is not returned again later;
+	// it is ignored for quiescence search
+	// ply is the distance from the root used for killer moves
+	void prepareMoveGeneration(SearchType type, const MoveInfo& transTableMove, uint16_t depth, uint16_t ply = 0);
 	MoveInfo getTopMove(const PositionState& pos, uint16_t depth, bool isQuiescenceSearch = false);
 
+	// Returns the stage which generated the move returned by the last
+	// getTopMove call, should be called before the search goes deeper
+	MoveGenerationStage currentStage() const;
+
+	// Updates killer moves, countermove and history of the quite
+	// move which caused beta cutoff in the position pos (before the move
+	// is made); history of the quite moves searched before it
+	// (failedMoves) is decreased
+	void updateQuiteMoveHeuristics(const PositionState& pos, const MoveInfo& move, uint16_t depth, uint16_t ply,
+			const MoveInfo* failedMoves, uint16_t failedMovesSize);
+
+	// Clears killer moves and ages history
+	// should be called before each new search
+	void resetMoveHeuristics();
+
 	// used only for perft testing
 	void generatePerftMoves(const PositionState& pos, uint16_t depth);
 
+	// used only for perft testing, returns the number of legal moves
+	// of pos, the moves of the pieces which are not pinned are counted
+	// from the bitboards without generating them, check and pin info
+	// of pos should be initialized for the depth
+	uint16_t countPerftMoves(const PositionState& pos, uint16_t depth);
+
+	// used only for benchmarking, generates the moves of the stage
+	// (GOOD_CAPTURING_MOVES for all the capturing moves, CHECKING_MOVES,
+	// QUITE_MOVES or EVASION_MOVES) without sorting them and returns
+	// their number, check and pin info of pos should be initialized
+	// for the depth
+	uint16_t generateStageMoves(const PositionState& pos, uint16_t depth, MoveGenerationStage stage);
+
+	// used only for benchmarking, returns the static
+	// exchange evaluation of the capturing move in pos
+	int16_t staticExchangeEval(const PositionState& pos, const MoveInfo& move);
+
 private:
 	MoveGenerator();
 	~MoveGenerator();
 	MoveGenerator(const MoveGenerator&); //non-copyable
 	MoveGenerator& operator=(const MoveGenerator&); //non-assignable
 
-	static MoveGenerator* _instance;
+	// Each search thread has its own move generator
+	static thread_local MoveGenerator* _instance;
 
 	void generateMovesForUsualSearch();
 	void generateMovesForEvasionSearch();
@@ -54,6 +97,12 @@ private:
 	// promoted piece is not a queen
 	void generateQuiteMoves();
 
+	// Adds valid killer moves and the countermove
+	// of the previous move to the available moves
+	void generateKillerMoves();
+
+	static void updateHistory(int16_t& history, int bonus);
+
 	void sortGoodCapturingMoves();
 	void sortBadCapturingMoves();
 	void sortCheckingMoves();
@@ -112,6 +161,16 @@ private:
 	MoveGenInfo* _moveGenInfo;
 	CheckPinInfo *_checkPinInfo;
 	int32_t* _gainSEE;
+
+	// Quite moves which caused beta cutoff for each ply
+	MoveInfo _killerMoves[MAX_SEARCH_PLY][KILLER_MOVES_PER_PLY];
+
+	// Butterfly history of quite moves indexed by moved piece and destination
+	int16_t _history[PIECE_COUNT][SQUARES_COUNT];
+
+	// Quite move which caused beta cutoff after the move of the piece
+	// (indexed by the moved piece and its destination)
+	MoveInfo _counterMoves[PIECE_COUNT][SQUARES_COUNT];
 };
 
 }
@@ -25,8 +25,6 @@
 namespace pismo
 {
 
-extern int bitCount(uint64_t);
-
 extern Bitboard KingZone[SQUARES_COUNT];
 
 uint16_t piecePhaseValue[PEACE_TYPE_COUNT] = {10, 32, 32, 50, 92, 0}; //all together
@@ -123,6 +121,7 @@ PositionEvaluation::PositionEvaluation():
 	_materialTable(0),
 	_pawnHash(0),
 	_currentPawnEval(0),
+	_evalHash(0),
 	_unusualMaterialPhase(0)
 {
 }
@@ -131,6 +130,7 @@ void PositionEvaluation::initPosEval()
 {
 	initMaterialTable();
 	initPawnHash();
+	initEvalHash();
 }
 
 template <Color clr>
@@ -391,6 +391,27 @@ void PositionEvaluation::initPawnHash()
 	}
 }
 
+void PositionEvaluation::clearPawnEntry(const PositionState& pos)
+{
+	PawnEvalInfo& pawnEval = _pawnHash[pos.getPawnKey() & PAWN_HASH_INDEX_MASK];
+	if (pawnEval.key == pos.getPawnKey()) {
+		pawnEval.key = ~pos.getPawnKey();
+	}
+}
+
+void PositionEvaluation::initEvalHash()
+{
+	_evalHash = new uint64_t[EVAL_HASH_SIZE];
+	for (unsigned int index = 0; index < EVAL_HASH_SIZE; ++index) {
+		_evalHash[index] = 0;
+	}
+}
+
+void PositionEvaluation::clearEvalEntry(const PositionState& pos)
+{
+	_evalHash[pos.getZobKey() & EVAL_HASH_INDEX_MASK] = 0;
+}
+
 void PositionEvaluation::reset(const PositionState& pos)
 {
 	//TODO: Init PositionState globally, and do not pass it into functions
@@ -410,12 +431,29 @@ void PositionEvaluation::reset(const PositionState& pos)
 
 int16_t PositionEvaluation::evaluate(const PositionState& pos)
 {
+	return evaluate(pos, -MAX_SCORE, MAX_SCORE);
+}
+
+POPCNT_CLONES
+int16_t PositionEvaluation::evaluate(const PositionState& pos, int16_t alpha, int16_t beta)
+{
+	uint64_t& evalEntry = _evalHash[pos.getZobKey() & EVAL_HASH_INDEX_MASK];
+	if (evalEntry && ((evalEntry ^ pos.getZobKey()) & ~EVAL_HASH_VALUE_MASK) == 0) {
+		return (int16_t) (evalEntry & EVAL_HASH_VALUE_MASK);
+	}
+
 	reset(pos);
 
 	incrScore(_score, _pos->getPstValue()._mgScore, _pos->getPstValue()._egScore, pst);
 
 	int16_t mValue = evalMaterial();
 
+	int16_t phase = _pos->unusualMaterial() ? _unusualMaterialPhase : _materialTable[_pos->materialKey()].phase;
+	int lazyValue = (_score._mgScore * phase  + _score._egScore * (128 - (int)phase) ) / 128 + mValue;
+	if (lazyValue + LAZY_EVAL_MARGIN <= alpha || lazyValue - LAZY_EVAL_MARGIN >= beta) {
+		return lazyValue;
+	}
+
 	evalPawnsState();
 
 	evalKnights<WHITE>();
@@ -434,10 +472,10 @@ int16_t PositionEvaluation::evaluate(const PositionState& pos)
 
 	//interpolate value between MG and EG phases and add material
 	// ( in material score phase should already be considered)
-	int16_t phase = _pos->unusualMaterial() ? _unusualMaterialPhase : _materialTable[_pos->materialKey()].phase;
   printEvalLog(phase);
 
 	int16_t value = (_score._mgScore * phase  + _score._egScore * (128 - (int)phase) ) / 128 + mValue;
+	evalEntry = (pos.getZobKey() & ~EVAL_HASH_VALUE_MASK) | (uint16_t) value;
 
 	return value;
 }
@@ -481,6 +519,7 @@ int16_t PositionEvaluation::evalMaterial()
 	}
 }
 
+POPCNT_CLONES
 void PositionEvaluation::evalPawnsState()
 {
 	_currentPawnEval = &_pawnHash[_pos->getPawnKey() & PAWN_HASH_INDEX_MASK];
@@ -518,7 +557,7 @@ void PositionEvaluation::evalPawnsState()
 }
 
 template <Color clr>
-void PositionEvaluation::evalKnights()
+POPCNT_INLINE void PositionEvaluation::evalKnights()
 {
 	assert(_currentPawnEval);
 	
@@ -550,7 +589,7 @@ void PositionEvaluation::evalKnights()
 }
 
 template <Color clr>
-void PositionEvaluation::evalBishops()
+POPCNT_INLINE void PositionEvaluation::evalBishops()
 {
 	Bitboard bishopsPos = _pos->_piecePos[clr == WHITE ? BISHOP_WHITE : BISHOP_BLACK];
 	int count = 0;
@@ -584,7 +623,7 @@ void PositionEvaluation::evalBishops()
 }
 
 template <Color clr>
-void PositionEvaluation::evalRooks()
+POPCNT_INLINE void PositionEvaluation::evalRooks()
 {
 	Bitboard rooksPos = _pos->_piecePos[clr == WHITE ? ROOK_WHITE : ROOK_BLACK];
 	int count = 0;
@@ -617,7 +656,7 @@ void PositionEvaluation::evalRooks()
 }
 
 template <Color clr>
-void PositionEvaluation::evalQueens()
+POPCNT_INLINE void PositionEvaluation::evalQueens()
 {
 	Bitboard queensPos = _pos->_piecePos[clr == WHITE ? QUEEN_WHITE : QUEEN_BLACK];
 	int count = 0;
@@ -649,6 +688,7 @@ PositionEvaluation::~PositionEvaluation()
 {
 	delete[] _materialTable;
 	delete[] _pawnHash;
+	delete[] _evalHash;
 }
 
 }
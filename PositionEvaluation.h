@@ -30,9 +30,21 @@ struct PawnEvalInfo
 	Bitboard blackPawnAttacks;
 };
 
+// Bound of the change of the value by the mobility and the pawn state
+// terms, the evaluation with the window returns the material and piece
+// square table value if it is outside the window by this margin
+const int16_t LAZY_EVAL_MARGIN = 250;
+
 const unsigned int PAWN_HASH_SIZE = 1 << 15;
 const unsigned int PAWN_HASH_INDEX_MASK = PAWN_HASH_SIZE - 1;
 
+// Entries of the evaluation hash keep the upper bits of the position
+// key and the (full) evaluation in the lowest 16 bits, the lower bits
+// of the key are the index, so the whole key is checked
+const unsigned int EVAL_HASH_SIZE = 1 << 16;
+const unsigned int EVAL_HASH_INDEX_MASK = EVAL_HASH_SIZE - 1;
+const uint64_t EVAL_HASH_VALUE_MASK = 0xffff;
+
 
 /**
  * https://chessprogramming.wikispaces.com/Evaluation
@@ -68,6 +80,28 @@ public:
 	void initPosEval();
 
 	int16_t evaluate(const PositionState& pos);
+
+	// Lazy evaluation: if the material and piece square table value
+	// is lower than alpha (or higher than beta) by LAZY_EVAL_MARGIN,
+	// it is returned without evaluating the other terms, alpha and
+	// beta are from the white side
+	int16_t evaluate(const PositionState& pos, int16_t alpha, int16_t beta);
+
+	// Starts loading the evaluation and pawn hash entries of the
+	// position with the given keys into the cache
+	void prefetch(ZobKey zobKey, ZobKey pawnKey) const
+	{
+		__builtin_prefetch(_evalHash + (zobKey & EVAL_HASH_INDEX_MASK));
+		__builtin_prefetch(_pawnHash + (pawnKey & PAWN_HASH_INDEX_MASK));
+	}
+
+	// used only for benchmarking, removes the pawn hash entry
+	// of pos, so that its pawn state is evaluated again
+	void clearPawnEntry(const PositionState& pos);
+
+	// used only for benchmarking, removes the evaluation hash
+	// entry of pos, so that it is evaluated again
+	void clearEvalEntry(const PositionState& pos);
   
 
 private:
@@ -89,20 +123,24 @@ private:
 	// and assigning all entries to 0 value
 	void initPawnHash();
 
+	// Initializes evaluation hash table, by allocating
+	// space and assigning all entries to 0 value
+	void initEvalHash();
+
 	//evaluate pawn structure
 	void evalPawnsState();
 
 	template <Color clr>
-	void evalKnights();
+	POPCNT_INLINE void evalKnights();
 
 	template <Color clr>
-	void evalBishops();
+	POPCNT_INLINE void evalBishops();
 
 	template <Color clr>
-	void evalRooks();
+	POPCNT_INLINE void evalRooks();
 
 	template <Color clr>
-	void evalQueens();
+	POPCNT_INLINE void evalQueens();
 
 	//Current position value in centi pawns
 	Score _score;
@@ -116,6 +154,11 @@ private:
 
 	PawnEvalInfo* _currentPawnEval;
 
+	// Hash table of the full (not lazy) evaluations, it is small
+	// and always replaced, the quiescence search uses it instead
+	// of storing the static evaluations in the transposition table
+	uint64_t* _evalHash;
+
 	int16_t _unusualMaterialPhase;
 
 	const PositionState* _pos;
@@ -6,6 +6,7 @@
 #include "MemPool.h"
 #include <assert.h>
 #include <cstdlib>
+#include <algorithm>
 #include <iostream>
 
 namespace pismo
@@ -49,11 +50,100 @@ _fullmoveCount(1)
 	} 
 }
 
+PositionState::PositionState(const PositionState& pos) :
+_zobKeyImpl(new ZobKeyImpl(*pos._zobKeyImpl))
+{
+	copyState(pos);
+}
+
+PositionState& PositionState::operator=(const PositionState& pos)
+{
+	if (this != &pos) {
+		copyState(pos);
+	}
+
+	return *this;
+}
+
 PositionState::~PositionState()
 {
 	delete _zobKeyImpl;
 }
 
+// Copies all the state variables except zobrist key generator,
+// which is the same for all the states
+void PositionState::copyState(const PositionState& pos)
+{
+	for (unsigned int i = 0; i < PIECE_COUNT; ++i) {
+		_pieceCount[i] = pos._pieceCount[i];
+		_piecePos[i] = pos._piecePos[i];
+	}
+	_whiteKingPosition = pos._whiteKingPosition;
+	_blackKingPosition = pos._blackKingPosition;
+	for (unsigned int i = 0; i < 8; ++i) {
+		for (unsigned int j = 0; j < 8; ++j) {
+			_board[i][j] = pos._board[i][j];
+		}
+	}
+	_whitePieces = pos._whitePieces;
+	_blackPieces = pos._blackPieces;
+	_occupiedSquares = pos._occupiedSquares;
+	_checkPinInfo = 0;
+	_bitboardImpl = pos._bitboardImpl;
+	_absolutePinsPos = pos._absolutePinsPos;
+	_isDoubleCheck = pos._isDoubleCheck;
+	_whiteToPlay = pos._whiteToPlay;
+	_enPassantFile = pos._enPassantFile;
+	_kingUnderCheck = pos._kingUnderCheck;
+	_whiteLeftCastling = pos._whiteLeftCastling;
+	_whiteRightCastling = pos._whiteRightCastling;
+	_blackLeftCastling = pos._blackLeftCastling;
+	_blackRightCastling = pos._blackRightCastling;
+	_zobKey = pos._zobKey;
+	_pawnZobKey = pos._pawnZobKey;
+	_materialKey = pos._materialKey;
+	_unusualMaterial = pos._unusualMaterial;
+	_pstValue = pos._pstValue;
+	_moveStack = pos._moveStack;
+	_halfmoveClock = pos._halfmoveClock;
+	_fullmoveCount = pos._fullmoveCount;
+}
+
+void PositionState::clearState()
+{
+	for (unsigned int i = 0; i < PIECE_COUNT; ++i) {
+		_pieceCount[i] = 0;
+		_piecePos[i] = 0;
+	}
+	_whiteKingPosition = E1;
+	_blackKingPosition = E8;
+	for (unsigned int i = 0; i < 8; ++i) {
+		for (unsigned int j = 0; j < 8; ++j) {
+			_board[i][j] = ETY_SQUARE;
+		}
+	}
+	_whitePieces = 0;
+	_blackPieces = 0;
+	_occupiedSquares = 0;
+	_absolutePinsPos = 0;
+	_isDoubleCheck = false;
+	_whiteToPlay = true;
+	_enPassantFile = -1;
+	_kingUnderCheck = false;
+	_whiteLeftCastling = false;
+	_whiteRightCastling = false;
+	_blackLeftCastling = false;
+	_blackRightCastling = false;
+	_zobKey = 0;
+	_pawnZobKey = 0;
+	_materialKey = 0;
+	_unusualMaterial = false;
+	_pstValue = Score(0, 0);
+	_moveStack = MoveStack();
+	_halfmoveClock = 0;
+	_fullmoveCount = 1;
+}
+
 void PositionState::setPiece(Square s, Piece p)
 {
 	_board[mRank(s)][mFile(s)] = p;
@@ -199,6 +289,7 @@ bool PositionState::initPositionIsValid(const std::vector<std::pair<Square, Piec
 
 void PositionState::initPositionFEN(const std::string& fen)
 {
+	clearState();
 	unsigned int charCount = 0;
 	initMaterialFEN(fen, charCount);
 	++charCount;
@@ -642,6 +733,17 @@ void PositionState::updateDiscoveredChecksInfo()
 	}
 }
 
+bool PositionState::moveGivesCheck(const MoveInfo& move) const
+{
+	Piece pfrom = _board[mRank(move.from)][mFile(move.from)];
+	Square slidingPiecePos;
+	return (squareToBitboard[move.to] & _checkPinInfo->_directCheck[pfrom]) ||
+		moveOpensDiscoveredCheck(move, slidingPiecePos) ||
+		(move.type == EN_PASSANT_CAPTURE && enPassantCaptureDiscoveresCheck(move, slidingPiecePos)) ||
+		(move.promoted != ETY_SQUARE && promotionMoveChecksOpponentKing(move)) ||
+		(move.type == CASTLING_MOVE && castlingChecksOpponentKing(move, slidingPiecePos));
+}
+
 void  PositionState::updateMoveChecksOpponentKing(const MoveInfo& move)
 {
 	Piece pfrom = _board[mRank(move.from)][mFile(move.from)];
@@ -1092,7 +1194,7 @@ bool PositionState::pinEnPassantCaptureOpensCheck(const MoveInfo& move) const
 	return false;
 }
 
-void PositionState::updateMoveType(MoveInfo& move)
+void PositionState::updateMoveType(MoveInfo& move) const
 {
 	Piece pfrom = _board[mRank(move.from)][mFile(move.from)];
 	Piece pto = _board[mRank(move.to)][mFile(move.to)];
@@ -1134,6 +1236,9 @@ void PositionState::updateMoveType(MoveInfo& move)
 		if (std::abs(move.to - move.from) == 2) {
 			move.type = CASTLING_MOVE;
 		}
+		else if (pto != ETY_SQUARE) {
+			move.type = CAPTURE_MOVE;
+		}
 		else {
 			move.type = NORMAL_MOVE;
 		}
@@ -1148,6 +1253,101 @@ void PositionState::updateMoveType(MoveInfo& move)
 	}
 }
 
+bool PositionState::moveIsPseudoLegal(MoveInfo& move) const
+{
+	if (move.from >= SQUARES_COUNT || move.to >= SQUARES_COUNT || move.from == move.to) {
+		return false;
+	}
+
+	Piece pfrom = _board[mRank(move.from)][mFile(move.from)];
+	Piece pto = _board[mRank(move.to)][mFile(move.to)];
+	Bitboard ownPieces = _whiteToPlay ? _whitePieces : _blackPieces;
+	if (pfrom == ETY_SQUARE || !(squareToBitboard[move.from] & ownPieces) ||
+			(squareToBitboard[move.to] & ownPieces) || pto == KING_WHITE || pto == KING_BLACK) {
+		return false;
+	}
+
+	bool isPromotion = (pfrom == PAWN_WHITE && move.from >= A7) || (pfrom == PAWN_BLACK && move.from <= H2);
+	if (isPromotion) {
+		int promotedType = move.promoted - (_whiteToPlay ? PAWN_WHITE : PAWN_BLACK);
+		if (move.promoted == ETY_SQUARE || promotedType < KNIGHT || promotedType > QUEEN) {
+			return false;
+		}
+	}
+	else if (move.promoted != ETY_SQUARE) {
+		return false;
+	}
+
+	Bitboard moveBoard = 0;
+	switch (pfrom) {
+		case PAWN_WHITE:
+			moveBoard = (_bitboardImpl->pawnWhiteAttackFrom(move.from) & _blackPieces) |
+				_bitboardImpl->pawnWhiteMovesFrom(move.from, _occupiedSquares);
+			if (_enPassantFile != -1 && move.from >= A5 && move.from <= H5) {
+				moveBoard |= _bitboardImpl->pawnWhiteAttackFrom(move.from) & squareToBitboard[enPassantTarget()];
+			}
+			break;
+		case PAWN_BLACK:
+			moveBoard = (_bitboardImpl->pawnBlackAttackFrom(move.from) & _whitePieces) |
+				_bitboardImpl->pawnBlackMovesFrom(move.from, _occupiedSquares);
+			if (_enPassantFile != -1 && move.from >= A4 && move.from <= H4) {
+				moveBoard |= _bitboardImpl->pawnBlackAttackFrom(move.from) & squareToBitboard[enPassantTarget()];
+			}
+			break;
+		case KNIGHT_WHITE:
+		case KNIGHT_BLACK:
+			moveBoard = _bitboardImpl->knightAttackFrom(move.from);
+			break;
+		case BISHOP_WHITE:
+		case BISHOP_BLACK:
+			moveBoard = _bitboardImpl->bishopAttackFrom(move.from, _occupiedSquares);
+			break;
+		case ROOK_WHITE:
+		case ROOK_BLACK:
+			moveBoard = _bitboardImpl->rookAttackFrom(move.from, _occupiedSquares);
+			break;
+		case QUEEN_WHITE:
+		case QUEEN_BLACK:
+			moveBoard = _bitboardImpl->queenAttackFrom(move.from, _occupiedSquares);
+			break;
+		case KING_WHITE:
+			moveBoard = _bitboardImpl->kingAttackFrom(move.from);
+			if (move.from == E1) {
+				if (_whiteLeftCastling && _board[RANK_1][FILE_A] == ROOK_WHITE &&
+						!(WHITE_LEFT_CASTLING_ETY_SQUARES & _occupiedSquares)) {
+					moveBoard |= squareToBitboard[C1];
+				}
+				if (_whiteRightCastling && _board[RANK_1][FILE_H] == ROOK_WHITE &&
+						!(WHITE_RIGHT_CASTLING_ETY_SQUARES & _occupiedSquares)) {
+					moveBoard |= squareToBitboard[G1];
+				}
+			}
+			break;
+		case KING_BLACK:
+			moveBoard = _bitboardImpl->kingAttackFrom(move.from);
+			if (move.from == E8) {
+				if (_blackLeftCastling && _board[RANK_8][FILE_A] == ROOK_BLACK &&
+						!(BLACK_LEFT_CASTLING_ETY_SQUARES & _occupiedSquares)) {
+					moveBoard |= squareToBitboard[C8];
+				}
+				if (_blackRightCastling && _board[RANK_8][FILE_H] == ROOK_BLACK &&
+						!(BLACK_RIGHT_CASTLING_ETY_SQUARES & _occupiedSquares)) {
+					moveBoard |= squareToBitboard[G8];
+				}
+			}
+			break;
+		default:
+			return false;
+	}
+
+	if (!(moveBoard & squareToBitboard[move.to])) {
+		return false;
+	}
+
+	updateMoveType(move);
+	return true;
+}
+
 void PositionState::makeMove(const MoveInfo& move)
 {
 	Piece pfrom = _board[mRank(move.from)][mFile(move.from)];
@@ -1165,6 +1365,8 @@ void PositionState::makeMove(const MoveInfo& move)
 	undoMove->isDoubleCheck = _isDoubleCheck;
 	undoMove->absolutePinsPos = _absolutePinsPos;
 	undoMove->moveType = move.type;
+	undoMove->zobKey = _zobKey;
+	undoMove->halfmoveClock = _halfmoveClock;
 
 	updateMoveChecksOpponentKing(move);
 
@@ -1193,11 +1395,62 @@ void PositionState::makeMove(const MoveInfo& move)
 
 	updateCastlingRights(move);
 
+	// castling is reversible for the fifty move rule, only
+	// pawn moves, captures and promotions reset the clock
+	if (move.type == CASTLING_MOVE ||
+		(move.type == NORMAL_MOVE && pfrom != PAWN_WHITE && pfrom != PAWN_BLACK)) {
+		++_halfmoveClock;
+	}
+	else {
+		_halfmoveClock = 0;
+	}
+	if (!_whiteToPlay) {
+		++_fullmoveCount;
+	}
+
 	_occupiedSquares = _whitePieces | _blackPieces;	
 	_whiteToPlay = !_whiteToPlay;
 	_zobKey ^= _zobKeyImpl->getIfBlackToPlayKey();
 }
 
+void PositionState::keysAfterMove(const MoveInfo& move, ZobKey& zobKey, ZobKey& pawnKey) const
+{
+	Piece pfrom = _board[mRank(move.from)][mFile(move.from)];
+	Piece pto = _board[mRank(move.to)][mFile(move.to)];
+	ZobKey fromKey = _zobKeyImpl->getPieceAtSquareKey(pfrom, move.from);
+	zobKey = _zobKey ^ fromKey ^ _zobKeyImpl->getIfBlackToPlayKey();
+	pawnKey = _pawnZobKey;
+	if (move.type == PROMOTION_MOVE) {
+		zobKey ^= _zobKeyImpl->getPieceAtSquareKey(move.promoted, move.to);
+		pawnKey ^= fromKey;
+	}
+	else {
+		ZobKey toKey = _zobKeyImpl->getPieceAtSquareKey(pfrom, move.to);
+		zobKey ^= toKey;
+		if (pfrom == PAWN_WHITE || pfrom == PAWN_BLACK) {
+			pawnKey ^= fromKey ^ toKey;
+		}
+	}
+	if (pto != ETY_SQUARE) {
+		zobKey ^= _zobKeyImpl->getPieceAtSquareKey(pto, move.to);
+		if (pto == PAWN_WHITE || pto == PAWN_BLACK) {
+			pawnKey ^= _zobKeyImpl->getPieceAtSquareKey(pto, move.to);
+		}
+	}
+	if (_enPassantFile != -1) {
+		zobKey ^= _zobKeyImpl->getEnPassantKey(_enPassantFile);
+	}
+	if (move.type == EN_PASSANT_MOVE) {
+		zobKey ^= _zobKeyImpl->getEnPassantKey(mFile(move.from));
+	}
+	else if (move.type == EN_PASSANT_CAPTURE) {
+		Square captured = (Square) (_whiteToPlay ? move.to - 8 : move.to + 8);
+		Piece capturedPawn = _whiteToPlay ? PAWN_BLACK : PAWN_WHITE;
+		zobKey ^= _zobKeyImpl->getPieceAtSquareKey(capturedPawn, captured);
+		pawnKey ^= _zobKeyImpl->getPieceAtSquareKey(capturedPawn, captured);
+	}
+}
+
 void PositionState::makeNormalMove(const MoveInfo& move)
 {
 	Piece pfrom = _board[mRank(move.from)][mFile(move.from)];
@@ -1578,6 +1831,59 @@ void PositionState::removePieceFromBitboards(Square sq, Piece p)
 	_piecePos[p] ^= squareToBitboard[sq];
 }
 
+void PositionState::makeNullMove()
+{
+	assert(!_kingUnderCheck);
+	UndoMoveInfo* undoMove = _moveStack.getNextItem();
+	undoMove->from = INVALID_SQUARE;
+	undoMove->to = INVALID_SQUARE;
+	undoMove->movedPiece = ETY_SQUARE;
+	undoMove->capturedPiece = ETY_SQUARE;
+	undoMove->enPassantFile = _enPassantFile;
+	undoMove->whiteLeftCastling = _whiteLeftCastling;
+	undoMove->whiteRightCastling = _whiteRightCastling;
+	undoMove->blackLeftCastling = _blackLeftCastling;
+	undoMove->blackRightCastling = _blackRightCastling;
+	undoMove->isDoubleCheck = _isDoubleCheck;
+	undoMove->absolutePinsPos = _absolutePinsPos;
+	undoMove->moveType = NULL_MOVE;
+	undoMove->zobKey = _zobKey;
+	undoMove->halfmoveClock = _halfmoveClock;
+
+	if (_enPassantFile != -1) {
+		_zobKey ^= _zobKeyImpl->getEnPassantKey(_enPassantFile);
+		_enPassantFile = -1;
+	}
+
+	// the positions before the null move are not
+	// checked for the repetitions
+	_halfmoveClock = 0;
+	_whiteToPlay = !_whiteToPlay;
+	_zobKey ^= _zobKeyImpl->getIfBlackToPlayKey();
+}
+
+void PositionState::undoNullMove()
+{
+	const UndoMoveInfo* move = _moveStack.pop();
+	assert(move->moveType == NULL_MOVE);
+	_halfmoveClock = move->halfmoveClock;
+	if (move->enPassantFile != -1) {
+		_enPassantFile = move->enPassantFile;
+		_zobKey ^= _zobKeyImpl->getEnPassantKey(_enPassantFile);
+	}
+
+	_whiteToPlay = !_whiteToPlay;
+	_zobKey ^= _zobKeyImpl->getIfBlackToPlayKey();
+}
+
+bool PositionState::sideToMoveHasOnlyPawns() const
+{
+	if (_whiteToPlay) {
+		return !(_pieceCount[KNIGHT_WHITE] | _pieceCount[BISHOP_WHITE] | _pieceCount[ROOK_WHITE] | _pieceCount[QUEEN_WHITE]);
+	}
+	return !(_pieceCount[KNIGHT_BLACK] | _pieceCount[BISHOP_BLACK] | _pieceCount[ROOK_BLACK] | _pieceCount[QUEEN_BLACK]);
+}
+
 void PositionState::undoMove()
 {
 	const UndoMoveInfo* move = _moveStack.pop();
@@ -1620,6 +1926,11 @@ void PositionState::undoMove()
 	   }
 	}
 
+	_halfmoveClock = move->halfmoveClock;
+	if (_whiteToPlay) {
+		--_fullmoveCount;
+	}
+
 	_occupiedSquares = _whitePieces | _blackPieces;
 	_whiteToPlay = !_whiteToPlay;
 	_zobKey ^= _zobKeyImpl->getIfBlackToPlayKey();
@@ -1930,6 +2241,7 @@ void PositionState::revertCastlingRights(const UndoMoveInfo& move)
 }
 	 
 PositionState::MoveStack::MoveStack() :
+_moveStack(MOVE_STACK_CAPACITY),
 _stackSize(0)
 {
 }
@@ -1949,14 +2261,58 @@ uint32_t PositionState::MoveStack::getSize() const
 // The value held in the variable to which the pointer points to is undefined  
 PositionState::UndoMoveInfo* PositionState::MoveStack::getNextItem()
 {
-	assert(_stackSize != MOVE_STACK_CAPACITY);
-	return _moveStack + (_stackSize++);
+	if (_stackSize == _moveStack.size()) {
+		_moveStack.resize(2 * _moveStack.size());
+	}
+	return &_moveStack[_stackSize++];
 }
 
 const PositionState::UndoMoveInfo* PositionState::MoveStack::pop()
 {
 	assert(!isEmpty());
-	return _moveStack + (--_stackSize);
+	return &_moveStack[--_stackSize];
+}
+
+const PositionState::UndoMoveInfo* PositionState::MoveStack::top() const
+{
+	assert(!isEmpty());
+	return &_moveStack[_stackSize - 1];
+}
+
+const PositionState::UndoMoveInfo* PositionState::MoveStack::fromTop(uint32_t n) const
+{
+	assert(n < _stackSize);
+	return &_moveStack[_stackSize - 1 - n];
+}
+
+bool PositionState::isDraw() const
+{
+	// if the king is under check, the position may be a mate,
+	// which is left to the search to find out
+	if (fiftyMoveRuleReached() && !_kingUnderCheck) {
+		return true;
+	}
+
+	// The same side is to play only after an even number of plies,
+	// and the position can not repeat earlier than in four plies
+	uint32_t reversibleCount = std::min((uint32_t) _halfmoveClock, _moveStack.getSize());
+	for (uint32_t i = 4; i <= reversibleCount; i += 2) {
+		if (_moveStack.fromTop(i - 1)->zobKey == _zobKey) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+MoveInfo PositionState::lastMove() const
+{
+	if (_moveStack.isEmpty()) {
+		return MoveInfo();
+	}
+
+	const UndoMoveInfo* move = _moveStack.top();
+	return move->moveType == NULL_MOVE ? MoveInfo() : MoveInfo(move->from, move->to);
 }
 
 const std::string PositionState::getStateFEN() const
@@ -13,7 +13,12 @@ class BitboardImpl;
 class ZobKeyImpl;
 struct CheckPinInfo;
 
-const unsigned int MOVE_STACK_CAPACITY = 100;
+// Initial capacity of the move stack, the stack grows
+// when the game and the search do not fit in it
+const unsigned int MOVE_STACK_CAPACITY = 256;
+
+// Number of the reversible halfmoves after which the game is drawn
+const uint16_t FIFTY_MOVE_RULE_PLIES = 100;
 
 class PositionState
 {
@@ -21,10 +26,18 @@ public:
 	PositionState();
 	~PositionState();
 
+	// Copies the whole state of the game including the move stack,
+	// so that the copy can be searched independently (e.g. by
+	// another search thread). Check and pin info is not shared and
+	// should be initialized for the copy by initCheckPinInfo()
+	PositionState(const PositionState& pos);
+	PositionState& operator=(const PositionState& pos);
+
 	void initPosition(const std::vector<std::pair<Square, Piece> >& pieces); 
 
 	// Initializes the state using Forsyth-Edwards notation string as an input
-	// the FEN should have 6 fields separated by whitespaces
+	// the FEN should have 6 fields separated by whitespaces, the previous
+	// state (including the made moves) is discarded
 	void initPositionFEN(const std::string& fen);
 
 	/*
@@ -39,6 +52,19 @@ public:
 	*/
 	void undoMove();
 
+	/*
+	Passes the move to the opponent without moving any piece
+	(used by null move pruning), should not be called if the
+	king is under check
+	*/
+	void makeNullMove();
+
+	/*
+	Reverts the null move made by makeNullMove, should be
+	called only if the last made move was null move
+	*/
+	void undoNullMove();
+
 	/* Checks to see whether pseudoMove is legal
 	   by checking whether the move is not pinned
 	   piece move which opens check
@@ -47,6 +73,12 @@ public:
 	*/
 	bool pseudoMoveIsLegalMove(const MoveInfo& move) const;
 
+	/* Checks whether the move checks the opponent king
+	   without making it, using the direct and discovered
+	   checks info of initCheckPinInfo()/updateCheckPinInfo()
+	*/
+	bool moveGivesCheck(const MoveInfo& move) const;
+
 	// Calculates direct check and discovered checks info
 	// and state pin info and stores it in the memory pool
 	// for appropriate depth
@@ -59,7 +91,16 @@ public:
 	/* Updates the move type, so that
 	   the move can be processed by makeMove
 	*/
-	void updateMoveType(MoveInfo& move);
+	void updateMoveType(MoveInfo& move) const;
+
+	/* Checks whether the move given by its from, to and
+	   promoted fields is pseudo legal in the current position
+	   (e.g. the move taken from transposition table, which
+	   may come from the different position because of key
+	   collision), and if so updates its type.
+	   Full legality should be checked by pseudoMoveIsLegalMove
+	*/
+	bool moveIsPseudoLegal(MoveInfo& move) const;
 
 	/*
 	Prints board for white pieces using information from 
@@ -87,6 +128,11 @@ public:
 	ZobKey getZobKey() const {return _zobKey;}
 	ZobKey getPawnKey() const {return _pawnZobKey;}
 
+	// Computes the keys of the position after the move without making
+	// it, the keys are exact for the moves which do not change castling
+	// rights, used only to prefetch the hash entries of the position
+	void keysAfterMove(const MoveInfo& move, ZobKey& zobKey, ZobKey& pawnKey) const;
+
 	Piece const (&getBoard()const)[8][8] {return _board;}
 
 	Score getPstValue() const {return _pstValue;}
@@ -113,10 +159,36 @@ public:
 	uint32_t materialKey() const {return _materialKey;}
 	uint16_t unusualMaterial() const {return _unusualMaterial;}
 
+	// Returns the last made move (only from and to squares),
+	// or invalid move if there are no moves made or the last
+	// move is null move
+	MoveInfo lastMove() const;
+
+	bool lastMoveIsNull() const {return !_moveStack.isEmpty() && _moveStack.top()->moveType == NULL_MOVE;}
+
+	/*
+	Returns true if the position is drawn by the fifty move rule
+	or repeats a position of the game (including the moves made by
+	the search), only the reversible moves since the last capture or
+	pawn move (or the last null move) are checked; the fifty move rule
+	in check is left to the caller, as it does not draw the mate
+	*/
+	bool isDraw() const;
+
+	bool fiftyMoveRuleReached() const {return _halfmoveClock >= FIFTY_MOVE_RULE_PLIES;}
+
+	// Returns true if the side to move has only king and pawns,
+	// where zugzwang is likely
+	bool sideToMoveHasOnlyPawns() const;
+
 	Square enPassantTarget() const {return _enPassantFile == -1 ? INVALID_SQUARE : (_whiteToPlay ? (Square) (A6 + _enPassantFile) : (Square) (A3 + _enPassantFile));}
 
 //private member functions
 private:
+	void copyState(const PositionState& pos);
+	// Removes all the pieces and resets the state
+	// variables to the values of the empty board
+	void clearState();
 	void setPiece(Square s, Piece p);
 	bool initPositionIsValid(const std::vector<std::pair<Square, Piece> >& pieces) const;
 	void initMaterialFEN(const std::string& fen, unsigned int& charCount);
@@ -184,7 +256,9 @@ private:
 		bool blackRightCastling;
 		bool isDoubleCheck;
 		Bitboard absolutePinsPos;
-
+		// Zobrist key and halfmove clock before the move
+		ZobKey zobKey;
+		uint16_t halfmoveClock;
 	};
 
 	void undoNormalMove(const UndoMoveInfo& move);
@@ -201,11 +275,14 @@ private:
 			MoveStack();
 			UndoMoveInfo* getNextItem();
 			const UndoMoveInfo* pop();
+			const UndoMoveInfo* top() const;
+			// Returns the item pushed n items before the top one
+			const UndoMoveInfo* fromTop(uint32_t n) const;
 			bool isEmpty() const;
 			uint32_t getSize() const;
 		
 		private:
-			UndoMoveInfo _moveStack[MOVE_STACK_CAPACITY];
+			std::vector<UndoMoveInfo> _moveStack;
 			uint32_t _stackSize;
 	};
 	
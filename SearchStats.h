@@ -0,0 +1,205 @@
+#ifndef SEARCHSTATS_H_
+#define SEARCHSTATS_H_
+
+// Search statistics are collected only if SEARCH_STATS is defined
+// (here or by -DSEARCH_STATS in CFLAGS), otherwise the STATS_*
+// macros expand to nothing and cost nothing
+
+//#define SEARCH_STATS
+
+#ifdef SEARCH_STATS
+
+#include "utils.h"
+#include "MemPool.h"
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+namespace pismo
+{
+
+const char* const STATS_STAGE_NAMES[SEARCH_FINISHED] = {"tt_move", "good_captures",
+	"bad_captures", "checking", "killers", "quiet", "evasions"};
+
+// Counters of one search thread, depth is the remaining depth
+// of the node (0 for quiescence search)
+struct SearchStats
+{
+	uint64_t mainNodes;
+	uint64_t qsearchNodes;
+
+	uint64_t ttProbes[MAX_SEARCH_DEPTH];
+	uint64_t ttHits[MAX_SEARCH_DEPTH];
+	uint64_t ttCutoffs[MAX_SEARCH_DEPTH];
+	// Hits with the stored move which is not pseudo legal,
+	// which means that the key fragments of two positions match
+	uint64_t ttMoveCollisions;
+	// Entries of other positions replaced by the new ones
+	uint64_t ttOverwrites;
+
+	// Beta cutoffs by the stage which generated the move
+	uint64_t betaCutoffs[SEARCH_FINISHED];
+	uint64_t firstMoveCutoffs;
+
+	// Nodes of each finished iteration of the main thread
+	uint64_t iterationNodes[MAX_SEARCH_DEPTH];
+
+	void reset() {std::memset(this, 0, sizeof(*this));}
+
+	// Adds the counters of other thread, the iterations
+	// are counted only by the main thread
+	void add(const SearchStats& other)
+	{
+		mainNodes += other.mainNodes;
+		qsearchNodes += other.qsearchNodes;
+		for (int i = 0; i < MAX_SEARCH_DEPTH; ++i) {
+			ttProbes[i] += other.ttProbes[i];
+			ttHits[i] += other.ttHits[i];
+			ttCutoffs[i] += other.ttCutoffs[i];
+		}
+		ttMoveCollisions += other.ttMoveCollisions;
+		ttOverwrites += other.ttOverwrites;
+		for (int i = 0; i < SEARCH_FINISHED; ++i) {
+			betaCutoffs[i] += other.betaCutoffs[i];
+		}
+		firstMoveCutoffs += other.firstMoveCutoffs;
+	}
+
+	std::string toJSON() const
+	{
+		uint64_t totalCutoffs = 0;
+		for (int i = 0; i < SEARCH_FINISHED; ++i) {
+			totalCutoffs += betaCutoffs[i];
+		}
+		uint64_t totalNodes = mainNodes + qsearchNodes;
+
+		std::string json = "{\"nodes\":{";
+		appendField(json, "main", mainNodes);
+		appendField(json, "qsearch", qsearchNodes);
+		appendRatio(json, "qsearch_share", qsearchNodes, totalNodes, true);
+
+		int maxDepth = MAX_SEARCH_DEPTH - 1;
+		while (maxDepth > 0 && !ttProbes[maxDepth]) {
+			--maxDepth;
+		}
+		json += "},\"tt\":{";
+		appendArray(json, "probes", ttProbes, maxDepth);
+		appendArray(json, "hits", ttHits, maxDepth);
+		appendArray(json, "cutoffs", ttCutoffs, maxDepth);
+		uint64_t totalProbes = 0;
+		uint64_t totalHits = 0;
+		for (int i = 0; i <= maxDepth; ++i) {
+			totalProbes += ttProbes[i];
+			totalHits += ttHits[i];
+		}
+		appendRatio(json, "hit_rate", totalHits, totalProbes);
+		appendField(json, "move_collisions", ttMoveCollisions);
+		appendField(json, "overwrites", ttOverwrites, true);
+
+		json += "},\"beta_cutoffs\":{";
+		for (int i = 0; i < SEARCH_FINISHED; ++i) {
+			appendField(json, STATS_STAGE_NAMES[i], betaCutoffs[i], i == SEARCH_FINISHED - 1);
+		}
+		json += "},";
+		appendRatio(json, "first_move_cutoff_rate", firstMoveCutoffs, totalCutoffs);
+
+		json += "\"iterations\":[";
+		char buffer[64];
+		for (int i = 1; i < MAX_SEARCH_DEPTH && iterationNodes[i]; ++i) {
+			uint64_t nodes = iterationNodes[i] - iterationNodes[i - 1];
+			uint64_t prevNodes = i > 1 ? iterationNodes[i - 1] - iterationNodes[i - 2] : 0;
+			std::snprintf(buffer, sizeof(buffer), "%s{\"depth\":%d,\"nodes\":%llu,\"ebf\":%.2f}", i > 1 ? "," : "",
+					i, (unsigned long long) nodes, prevNodes ? (double) nodes / prevNodes : 0.0);
+			json += buffer;
+		}
+		json += "]}";
+
+		return json;
+	}
+
+private:
+	static void appendField(std::string& json, const char* name, uint64_t value, bool last = false)
+	{
+		char buffer[64];
+		std::snprintf(buffer, sizeof(buffer), "\"%s\":%llu%s", name, (unsigned long long) value, last ? "" : ",");
+		json += buffer;
+	}
+
+	static void appendRatio(std::string& json, const char* name, uint64_t value, uint64_t total, bool last = false)
+	{
+		char buffer[64];
+		std::snprintf(buffer, sizeof(buffer), "\"%s\":%.4f%s", name, total ? (double) value / total : 0.0, last ? "" : ",");
+		json += buffer;
+	}
+
+	static void appendArray(std::string& json, const char* name, const uint64_t* values, int maxIndex)
+	{
+		json += '"';
+		json += name;
+		json += "\":[";
+		char buffer[32];
+		for (int i = 0; i <= maxIndex; ++i) {
+			std::snprintf(buffer, sizeof(buffer), "%s%llu", i ? "," : "", (unsigned long long) values[i]);
+			json += buffer;
+		}
+		json += "],";
+	}
+};
+
+// Each search thread collects its own statistics
+inline SearchStats& searchStats()
+{
+	static thread_local SearchStats stats;
+	return stats;
+}
+
+// Sum of the statistics of the helper threads, each helper adds
+// its own statistics before it finishes
+inline SearchStats& helperStats()
+{
+	static SearchStats stats;
+	return stats;
+}
+
+inline std::mutex& helperStatsMutex()
+{
+	static std::mutex mtx;
+	return mtx;
+}
+
+inline void mergeHelperStats()
+{
+	std::lock_guard<std::mutex> lck(helperStatsMutex());
+	helperStats().add(searchStats());
+}
+
+// Statistics of all the threads, called after the helpers finish
+inline void printStats()
+{
+	SearchStats stats = searchStats();
+	stats.add(helperStats());
+	std::fprintf(stdout, "info string stats %s\n", stats.toJSON().c_str());
+}
+
+}
+
+#define STATS_INCR(counter) (++pismo::searchStats().counter)
+#define STATS_SET(counter, value) (pismo::searchStats().counter = (value))
+#define STATS_RESET() pismo::searchStats().reset()
+#define STATS_RESET_HELPERS() pismo::helperStats().reset()
+#define STATS_MERGE_HELPER() pismo::mergeHelperStats()
+#define STATS_PRINT() pismo::printStats()
+
+#else
+
+#define STATS_INCR(counter)
+#define STATS_SET(counter, value)
+#define STATS_RESET()
+#define STATS_RESET_HELPERS()
+#define STATS_MERGE_HELPER()
+#define STATS_PRINT()
+
+#endif
+
+#endif //SEARCHSTATS_H_
@@ -0,0 +1,161 @@
+#include "SliderAttacks.h"
+
+namespace pismo
+{
+
+// Sizes of the index tables of all the squares, the table of the
+// square has an entry for each subset of its relevant occupancy
+const std::size_t ROOK_TABLE_SIZE = 102400;
+const std::size_t BISHOP_TABLE_SIZE = 5248;
+
+// Numbers of the distinct attacks of all the squares, the attacks
+// differ only by the first blocker of each ray (at most 144 per square)
+const std::size_t ROOK_ATTACKS_SIZE = 4900;
+const std::size_t BISHOP_ATTACKS_SIZE = 1428;
+
+// Relevant occupancy has at most 12 squares (rook in the corner)
+const std::size_t MAX_SQUARE_TABLE_SIZE = 1 << 12;
+
+// Seeds of the magic search for the squares of each rank, they
+// are known to find the magics of all the squares quickly
+const uint64_t MAGIC_SEEDS[8] = {728, 10316, 55013, 32803, 12281, 15100, 16645, 255};
+
+const int ROOK_DIRECTIONS[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+const int BISHOP_DIRECTIONS[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+
+// Attacks of the slider on the square by walking the rays
+// in (rank, file) directions until the occupied square
+inline Bitboard rayAttacks(Square sq, Bitboard occupied, const int directions[4][2])
+{
+	Bitboard attacks = 0;
+	for (unsigned int i = 0; i < 4; ++i) {
+		int rank = mRank(sq) + directions[i][0];
+		int file = mFile(sq) + directions[i][1];
+		while (rank >= 0 && rank < 8 && file >= 0 && file < 8) {
+			Bitboard square = 1ULL << (rank * 8 + file);
+			attacks |= square;
+			if (occupied & square) {
+				break;
+			}
+			rank += directions[i][0];
+			file += directions[i][1];
+		}
+	}
+
+	return attacks;
+}
+
+// Squares which may block the slider on the square, the edges
+// do not change the attacks, as there is nothing behind them
+inline Bitboard relevantOccupancy(Square sq, const int directions[4][2])
+{
+	const Bitboard rankEdges = 0xFF000000000000FFULL;
+	const Bitboard fileEdges = 0x8181818181818181ULL;
+	Bitboard sqRank = 0xFFULL << (mRank(sq) * 8);
+	Bitboard sqFile = 0x0101010101010101ULL << mFile(sq);
+	Bitboard edges = (rankEdges & ~sqRank) | (fileEdges & ~sqFile);
+	return rayAttacks(sq, 0, directions) & ~edges;
+}
+
+// xorshift64* generator, magics with few set bits are found faster
+inline uint64_t sparseRandom(uint64_t& state)
+{
+	uint64_t result = ~0ULL;
+	for (unsigned int i = 0; i < 3; ++i) {
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		result &= state * 2685821657736338717ULL;
+	}
+
+	return result;
+}
+
+// Fills the index tables of all the squares starting at indices and
+// their distinct attacks starting at attacks, the subsets of the occupancy
+// are enumerated in the increasing order, which is the order of pext
+// indices, if findMagics is true the magics mapping the subsets to the
+// index table without collisions are found
+inline void initSliderTables(SliderMagic magics[], uint8_t* indices, Bitboard* attacks,
+		const int directions[4][2], bool findMagics)
+{
+	std::vector<Bitboard> occupancies(MAX_SQUARE_TABLE_SIZE);
+	std::vector<uint8_t> references(MAX_SQUARE_TABLE_SIZE);
+	std::vector<unsigned int> epoch(MAX_SQUARE_TABLE_SIZE, 0);
+	unsigned int attempt = 0;
+
+	for (unsigned int sq = A1; sq <= H8; ++sq) {
+		SliderMagic& m = magics[sq];
+		m.mask = relevantOccupancy((Square) sq, directions);
+		m.magic = 0;
+		m.shift = 64 - bitCount(m.mask);
+		m.indices = indices;
+		m.attacks = attacks;
+
+		std::size_t size = 0;
+		std::size_t attacksSize = 0;
+		Bitboard occupied = 0;
+		do {
+			Bitboard reference = rayAttacks((Square) sq, occupied, directions);
+			std::size_t id = 0;
+			while (id < attacksSize && m.attacks[id] != reference) {
+				++id;
+			}
+			if (id == attacksSize) {
+				m.attacks[attacksSize++] = reference;
+			}
+			occupancies[size] = occupied;
+			references[size] = id;
+			++size;
+			occupied = (occupied - m.mask) & m.mask;
+		} while (occupied);
+		indices += size;
+		attacks += attacksSize;
+
+		if (!findMagics) {
+			for (std::size_t i = 0; i < size; ++i) {
+				m.indices[i] = references[i];
+			}
+			continue;
+		}
+
+		uint64_t state = MAGIC_SEEDS[mRank(sq)];
+		std::size_t i = 0;
+		while (i < size) {
+			do {
+				m.magic = sparseRandom(state);
+			} while (bitCount((m.magic * m.mask) >> 56) < 6);
+			++attempt;
+			for (i = 0; i < size; ++i) {
+				std::size_t index = (occupancies[i] * m.magic) >> m.shift;
+				if (epoch[index] < attempt) {
+					epoch[index] = attempt;
+					m.indices[index] = references[i];
+				}
+				else if (m.indices[index] != references[i]) {
+					break;
+				}
+			}
+		}
+	}
+}
+
+FancyMagicSliders::FancyMagicSliders() :
+_indices(ROOK_TABLE_SIZE + BISHOP_TABLE_SIZE),
+_attacks(ROOK_ATTACKS_SIZE + BISHOP_ATTACKS_SIZE)
+{
+	initSliderTables(_rookMagics, &_indices[0], &_attacks[0], ROOK_DIRECTIONS, true);
+	initSliderTables(_bishopMagics, &_indices[ROOK_TABLE_SIZE], &_attacks[ROOK_ATTACKS_SIZE], BISHOP_DIRECTIONS, true);
+}
+
+#ifdef __BMI2__
+PextSliders::PextSliders() :
+_indices(ROOK_TABLE_SIZE + BISHOP_TABLE_SIZE),
+_attacks(ROOK_ATTACKS_SIZE + BISHOP_ATTACKS_SIZE)
+{
+	initSliderTables(_rookMagics, &_indices[0], &_attacks[0], ROOK_DIRECTIONS, false);
+	initSliderTables(_bishopMagics, &_indices[ROOK_TABLE_SIZE], &_attacks[ROOK_ATTACKS_SIZE], BISHOP_DIRECTIONS, false);
+}
+#endif
+
+}
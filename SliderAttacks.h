@@ -0,0 +1,162 @@
+#ifndef SLIDERATTACKS_H_
+#define SLIDERATTACKS_H_
+
+#include "utils.h"
+#include "MagicMoves.h"
+#include <vector>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+namespace pismo
+{
+
+/**
+ * Backends of the rook and bishop attacks, each of them computes
+ * the attacks of the slider on the square for the occupancy:
+ * MagicMovesSliders  - the magicmoves tables (841KB)
+ * FancyMagicSliders  - magics with the shift and the table offset per square,
+ *                      the tables hold 1 byte indices of the distinct attacks
+ *                      of the square (105KB of indices and 49KB of attacks)
+ * PextSliders        - the same tables indexed by the BMI2 pext instruction
+ * KoggeStoneSliders  - occluded fills without tables
+ * The engine uses SliderAttacks, which is chosen at build time by
+ * make SLIDERS=magicmoves|fancy|pext|koggestone, the tests and the
+ * benchmarks use the backends directly
+ */
+
+class MagicMovesSliders
+{
+public:
+	MagicMovesSliders() {initmagicmoves();}
+
+	Bitboard rookAttacks(Square sq, Bitboard occupied) const {return Rmagic(sq, occupied);}
+	Bitboard bishopAttacks(Square sq, Bitboard occupied) const {return Bmagic(sq, occupied);}
+};
+
+// Masked occupancy of the square is mapped to the entry of the
+// index table of the square, which holds the index of its attacks
+// in the distinct attacks of the square
+struct SliderMagic
+{
+	Bitboard mask;
+	Bitboard magic;
+	uint8_t* indices;
+	Bitboard* attacks;
+	unsigned int shift;
+};
+
+class FancyMagicSliders
+{
+public:
+	FancyMagicSliders();
+
+	Bitboard rookAttacks(Square sq, Bitboard occupied) const
+	{
+		const SliderMagic& m = _rookMagics[sq];
+		return m.attacks[m.indices[((occupied & m.mask) * m.magic) >> m.shift]];
+	}
+
+	Bitboard bishopAttacks(Square sq, Bitboard occupied) const
+	{
+		const SliderMagic& m = _bishopMagics[sq];
+		return m.attacks[m.indices[((occupied & m.mask) * m.magic) >> m.shift]];
+	}
+
+private:
+	FancyMagicSliders(const FancyMagicSliders&); // non-copyable
+	FancyMagicSliders& operator=(const FancyMagicSliders&); // non-assignable
+
+	SliderMagic _rookMagics[SQUARES_COUNT];
+	SliderMagic _bishopMagics[SQUARES_COUNT];
+	std::vector<uint8_t> _indices;
+	std::vector<Bitboard> _attacks;
+};
+
+#ifdef __BMI2__
+class PextSliders
+{
+public:
+	PextSliders();
+
+	Bitboard rookAttacks(Square sq, Bitboard occupied) const
+	{
+		const SliderMagic& m = _rookMagics[sq];
+		return m.attacks[m.indices[_pext_u64(occupied, m.mask)]];
+	}
+
+	Bitboard bishopAttacks(Square sq, Bitboard occupied) const
+	{
+		const SliderMagic& m = _bishopMagics[sq];
+		return m.attacks[m.indices[_pext_u64(occupied, m.mask)]];
+	}
+
+private:
+	PextSliders(const PextSliders&); // non-copyable
+	PextSliders& operator=(const PextSliders&); // non-assignable
+
+	SliderMagic _rookMagics[SQUARES_COUNT];
+	SliderMagic _bishopMagics[SQUARES_COUNT];
+	std::vector<uint8_t> _indices;
+	std::vector<Bitboard> _attacks;
+};
+#endif
+
+// https://chessprogramming.wikispaces.com/Kogge-Stone+Algorithm
+class KoggeStoneSliders
+{
+public:
+	Bitboard rookAttacks(Square sq, Bitboard occupied) const
+	{
+		Bitboard slider = 1ULL << sq;
+		Bitboard empty = ~occupied;
+		return fill<8>(slider, empty, ~0ULL) | fill<-8>(slider, empty, ~0ULL) |
+			fill<1>(slider, empty, NOT_A_FILE) | fill<-1>(slider, empty, NOT_H_FILE);
+	}
+
+	Bitboard bishopAttacks(Square sq, Bitboard occupied) const
+	{
+		Bitboard slider = 1ULL << sq;
+		Bitboard empty = ~occupied;
+		return fill<9>(slider, empty, NOT_A_FILE) | fill<-7>(slider, empty, NOT_A_FILE) |
+			fill<7>(slider, empty, NOT_H_FILE) | fill<-9>(slider, empty, NOT_H_FILE);
+	}
+
+private:
+	static const Bitboard NOT_A_FILE = 0xFEFEFEFEFEFEFEFEULL;
+	static const Bitboard NOT_H_FILE = 0x7F7F7F7F7F7F7F7FULL;
+
+	template <int dir>
+	static Bitboard shift(Bitboard board) {return dir > 0 ? board << (dir & 63) : board >> (-dir & 63);}
+
+	// Attacks of the sliders in the direction, wrapMask removes
+	// the squares the shift in the direction wraps to
+	template <int dir>
+	static Bitboard fill(Bitboard sliders, Bitboard empty, Bitboard wrapMask)
+	{
+		empty &= wrapMask;
+		sliders |= empty & shift<dir>(sliders);
+		empty &= shift<dir>(empty);
+		sliders |= empty & shift<2 * dir>(sliders);
+		empty &= shift<2 * dir>(empty);
+		sliders |= empty & shift<4 * dir>(sliders);
+		return shift<dir>(sliders) & wrapMask;
+	}
+};
+
+#if defined(SLIDERS_PEXT)
+#ifndef __BMI2__
+#error "SLIDERS=pext needs the BMI2 build (make ARCH=bmi2)"
+#endif
+class SliderAttacks : public PextSliders {};
+#elif defined(SLIDERS_FANCY_MAGIC)
+class SliderAttacks : public FancyMagicSliders {};
+#elif defined(SLIDERS_KOGGE_STONE)
+class SliderAttacks : public KoggeStoneSliders {};
+#else
+class SliderAttacks : public MagicMovesSliders {};
+#endif
+
+}
+
+#endif //SLIDERATTACKS_H_
@@ -1,42 +1,275 @@
 #include "TranspositionTable.h"
 #include "PositionState.h"
+#include "SearchStats.h"
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <new>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
 
 namespace pismo
 {
 
-TranspositionTable::TranspositionTable():
-_hash(HASH_TABLE_SIZE)
+const unsigned int TT_KEY_SHIFT = 44;
+const unsigned int TT_MOVE_SHIFT = 20;
+const unsigned int TT_SCORE_SHIFT = 36;
+const unsigned int TT_DEPTH_SHIFT = 51;
+const unsigned int TT_BOUND_SHIFT = 57;
+const unsigned int TT_AGE_SHIFT = 59;
+const TTEntry TT_KEY_MASK = 0xFFFFF;
+const TTEntry TT_SCORE_MASK = 0x7FFF;
+const unsigned int TT_MAX_DEPTH = 0x3F;
+
+// Replacement worth of the entry is its depth, the exact bound
+// adds TT_EXACT_BOUND_WORTH and each search generation passed
+// since the entry was stored takes TT_AGE_WORTH
+const int TT_EXACT_BOUND_WORTH = 2;
+const int TT_AGE_WORTH = 8;
+
+inline uint32_t entryKey(TTEntry entry) {return entry & TT_KEY_MASK;}
+inline uint16_t entryDepth(TTEntry entry) {return (entry >> TT_DEPTH_SHIFT) & TT_MAX_DEPTH;}
+inline BoundType entryBound(TTEntry entry) {return (BoundType) ((entry >> TT_BOUND_SHIFT) & 0x3);}
+inline bool entryIsEmpty(TTEntry entry) {return ((entry >> TT_BOUND_SHIFT) & 0x3) == 0;}
+inline unsigned int entryAge(TTEntry entry) {return entry >> TT_AGE_SHIFT;}
+
+// Tables at least of this size are allocated on 2MB boundary
+// and advised to be backed by transparent huge pages
+const std::size_t TT_HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// Tables at least of this size are cleared in parallel
+const std::size_t TT_PARALLEL_CLEAR_SIZE = 64 * 1024 * 1024;
+
+// Number of buckets counted by hashfull (1000 entries)
+const std::size_t TT_HASHFULL_BUCKET_COUNT = 125;
+
+TranspositionTable::TranspositionTable(unsigned int sizeMB):
+_buckets(0),
+_bucketCount(0),
+_bucketMask(0),
+_sizeMB(0),
+_generation(0)
+{
+	allocate(sizeMB);
+	clear();
+}
+
+TranspositionTable::~TranspositionTable()
 {
+	deallocate();
 }
 
-bool TranspositionTable::contains(const PositionState& pos, EvalInfo& eval) const
+void TranspositionTable::resize(unsigned int sizeMB)
 {
-	unsigned int index = hashFunction(pos.getZobKey());
-	if (_hash[index].zobKey == pos.getZobKey()) {
-		eval = _hash[index];
-		return true;
+	deallocate();
+	allocate(sizeMB);
+	clear();
+}
+
+void TranspositionTable::allocate(unsigned int sizeMB)
+{
+	if (sizeMB < TT_MIN_SIZE_MB) {
+		sizeMB = TT_MIN_SIZE_MB;
+	}
+	else if (sizeMB > TT_MAX_SIZE_MB) {
+		sizeMB = TT_MAX_SIZE_MB;
+	}
+
+	std::size_t bucketCount = (std::size_t) sizeMB * 1024 * 1024 / sizeof(TTBucket);
+	_bucketCount = 1;
+	while (_bucketCount * 2 <= bucketCount) {
+		_bucketCount *= 2;
+	}
+	_bucketMask = _bucketCount - 1;
+	_sizeMB = sizeMB;
+
+	std::size_t size = _bucketCount * sizeof(TTBucket);
+	std::size_t alignment = size >= TT_HUGE_PAGE_SIZE ? TT_HUGE_PAGE_SIZE : sizeof(TTBucket);
+	void* memory = 0;
+	if (posix_memalign(&memory, alignment, size)) {
+		throw std::bad_alloc();
 	}
-	else {
-		return false;
+#ifdef MADV_HUGEPAGE
+	if (size >= TT_HUGE_PAGE_SIZE) {
+		// only advice, the table works the same if it fails
+		madvise(memory, size, MADV_HUGEPAGE);
 	}
+#endif
+	_buckets = static_cast<TTBucket*>(memory);
+}
+
+void TranspositionTable::deallocate()
+{
+	std::free(_buckets);
+	_buckets = 0;
+}
+
+void TranspositionTable::clear()
+{
+	std::size_t size = _bucketCount * sizeof(TTBucket);
+	unsigned int threadCount = std::thread::hardware_concurrency();
+	if (size < TT_PARALLEL_CLEAR_SIZE || threadCount < 2) {
+		std::memset(_buckets, 0, size);
+		return;
+	}
+
+	// bucket count is a power of 2, so it is enough to
+	// round the thread count down to a power of 2
+	unsigned int chunkCount = 1;
+	while (chunkCount * 2 <= threadCount) {
+		chunkCount *= 2;
+	}
+	std::size_t chunkSize = _bucketCount / chunkCount;
+	std::vector<std::thread> threads;
+	for (unsigned int i = 0; i < chunkCount; ++i) {
+		TTBucket* chunk = _buckets + i * chunkSize;
+		threads.push_back(std::thread([=]() {std::memset(chunk, 0, chunkSize * sizeof(TTBucket));}));
+	}
+	for (std::size_t i = 0; i < threads.size(); ++i) {
+		threads[i].join();
+	}
+}
+
+bool TranspositionTable::contains(const PositionState& pos, EvalInfo& eval)
+{
+	TTBucket* bucket = getBucket(pos.getZobKey());
+	uint32_t key = pos.getZobKey() >> TT_KEY_SHIFT;
+	for (unsigned int i = 0; i < TT_BUCKET_ENTRY_COUNT; ++i) {
+		TTEntry entry = bucket->entries[i];
+		if (entryKey(entry) == key && !entryIsEmpty(entry)) {
+			if (entryAge(entry) != _generation) {
+				bucket->entries[i] = (entry & ~(~(TTEntry) 0 << TT_AGE_SHIFT)) | ((TTEntry) _generation << TT_AGE_SHIFT);
+			}
+			unpackEntry(entry, eval);
+			eval.zobKey = pos.getZobKey();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+unsigned int TranspositionTable::hashfull() const
+{
+	std::size_t bucketCount = std::min(_bucketCount, TT_HASHFULL_BUCKET_COUNT);
+	std::size_t usedCount = 0;
+	for (std::size_t i = 0; i < bucketCount; ++i) {
+		for (unsigned int j = 0; j < TT_BUCKET_ENTRY_COUNT; ++j) {
+			TTEntry entry = _buckets[i].entries[j];
+			if (!entryIsEmpty(entry) && entryAge(entry) == _generation) {
+				++usedCount;
+			}
+		}
+	}
+
+	return usedCount * 1000 / (bucketCount * TT_BUCKET_ENTRY_COUNT);
 }
 
 void TranspositionTable::push(const EvalInfo& eval)
 {
-	unsigned int index = hashFunction(eval.zobKey);
-	if ((_hash[index].zobKey != eval.zobKey) || (_hash[index].depth < eval.depth)) {
-		_hash[index] = eval;
+	TTBucket* bucket = getBucket(eval.zobKey);
+	uint32_t key = eval.zobKey >> TT_KEY_SHIFT;
+	for (unsigned int i = 0; i < TT_BUCKET_ENTRY_COUNT; ++i) {
+		TTEntry entry = bucket->entries[i];
+		if (entryKey(entry) == key && !entryIsEmpty(entry)) {
+			if (entryDepth(entry) < eval.depth || entryAge(entry) != _generation) {
+				bucket->entries[i] = packEntry(eval);
+			}
+			return;
+		}
+	}
+
+	TTEntry* replaced = replacementEntry(bucket);
+	if (!entryIsEmpty(*replaced)) {
+		STATS_INCR(ttOverwrites);
 	}
+	*replaced = packEntry(eval);
 }
 
 void TranspositionTable::forcePush(const EvalInfo& eval)
 {
-	_hash[hashFunction(eval.zobKey)] = eval;
+	TTBucket* bucket = getBucket(eval.zobKey);
+	uint32_t key = eval.zobKey >> TT_KEY_SHIFT;
+	for (unsigned int i = 0; i < TT_BUCKET_ENTRY_COUNT; ++i) {
+		if (entryKey(bucket->entries[i]) == key && !entryIsEmpty(bucket->entries[i])) {
+			bucket->entries[i] = packEntry(eval);
+			return;
+		}
+	}
+
+	TTEntry* replaced = replacementEntry(bucket);
+	if (!entryIsEmpty(*replaced)) {
+		STATS_INCR(ttOverwrites);
+	}
+	*replaced = packEntry(eval);
+}
+
+// Returns the first empty entry of the bucket if any,
+// otherwise the entry with the smallest worth
+TTEntry* TranspositionTable::replacementEntry(TTBucket* bucket) const
+{
+	TTEntry* replace = bucket->entries;
+	int replaceWorth = entryWorth(*replace);
+	for (unsigned int i = 0; i < TT_BUCKET_ENTRY_COUNT; ++i) {
+		if (entryIsEmpty(bucket->entries[i])) {
+			return bucket->entries + i;
+		}
+		int worth = entryWorth(bucket->entries[i]);
+		if (worth < replaceWorth) {
+			replace = bucket->entries + i;
+			replaceWorth = worth;
+		}
+	}
+
+	return replace;
+}
+
+int TranspositionTable::entryWorth(TTEntry entry) const
+{
+	unsigned int age = (_generation + TT_GENERATION_COUNT - entryAge(entry)) % TT_GENERATION_COUNT;
+	return entryDepth(entry) + (entryBound(entry) == EXACT_BOUND ? TT_EXACT_BOUND_WORTH : 0) - (int) age * TT_AGE_WORTH;
+}
+
+TTEntry TranspositionTable::packEntry(const EvalInfo& eval) const
+{
+	TTEntry depth = eval.depth < TT_MAX_DEPTH ? eval.depth : TT_MAX_DEPTH;
+	return (eval.zobKey >> TT_KEY_SHIFT) |
+		((TTEntry) packMove(eval.move) << TT_MOVE_SHIFT) |
+		(((TTEntry) (uint16_t) eval.posValue & TT_SCORE_MASK) << TT_SCORE_SHIFT) |
+		(depth << TT_DEPTH_SHIFT) |
+		((TTEntry) eval.bound << TT_BOUND_SHIFT) |
+		((TTEntry) _generation << TT_AGE_SHIFT);
+}
+
+void TranspositionTable::unpackEntry(TTEntry entry, EvalInfo& eval) const
+{
+	// the sign bit of the score is extended from 15 bits
+	eval.posValue = (int16_t) (((entry >> TT_SCORE_SHIFT) & TT_SCORE_MASK) << 1) >> 1;
+	eval.depth = entryDepth(entry);
+	eval.bound = entryBound(entry);
+	eval.move = unpackMove((uint16_t) (entry >> TT_MOVE_SHIFT));
 }
 
-unsigned int TranspositionTable::hashFunction(const ZobKey& zobKey) const
+// The move is packed into 16 bits as from (6 bits), to (6 bits)
+// and promoted piece (4 bits), 0 stands for no move, as from
+// and to squares of the real move cannot be the same
+uint16_t TranspositionTable::packMove(const MoveInfo& move) const
 {
-	return (zobKey % HASH_TABLE_SIZE);
-	//TODO:Change the impl to return first log(HASH_TABLE_SIZE) + 1 bits of zobKey
+	if (move.from == INVALID_SQUARE) {
+		return 0;
+	}
+
+	return move.from | (move.to << 6) | (move.promoted << 12);
+}
+
+MoveInfo TranspositionTable::unpackMove(uint16_t move) const
+{
+	if (move == 0) {
+		return MoveInfo();
+	}
+
+	return MoveInfo((Square) (move & 0x3F), (Square) ((move >> 6) & 0x3F), (Piece) (move >> 12));
 }
+
 }
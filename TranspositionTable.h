@@ -2,23 +2,87 @@
 #define TRANSPOSITION_TABLE_
 
 #include "utils.h"
-#include <vector>
+#include <cstddef>
 
 namespace pismo
 {
 class PositionState;
-const unsigned int HASH_TABLE_SIZE = 1000000;
+
+// Number of packed entries in the bucket, the bucket
+// takes exactly one cache line (64 bytes)
+const unsigned int TT_BUCKET_ENTRY_COUNT = 8;
+
+// Number of the search generations kept in the age bits of
+// the entries, the age of the entry is relative modulo it
+const unsigned int TT_GENERATION_COUNT = 32;
+
+// Size limits of the table in megabytes, the number of
+// buckets is the biggest power of 2 which fits in the size
+const unsigned int TT_DEFAULT_SIZE_MB = 8;
+const unsigned int TT_MIN_SIZE_MB = 1;
+const unsigned int TT_MAX_SIZE_MB = 65536;
+
+/**
+ * Each entry is packed into 64 bits, so that it is read and
+ * written by single memory access:
+ * bits  0-19 key fragment (the highest 20 bits of zobKey)
+ * bits 20-35 move (from 6 bits, to 6 bits, promoted piece 4 bits)
+ * bits 36-50 score (|score| <= MAX_SCORE fits 15 bits)
+ * bits 51-56 depth (less than MAX_SEARCH_DEPTH)
+ * bits 57-58 bound type
+ * bits 59-63 age (generation of the search which stored it)
+ * The lowest bits of the zobKey are used as bucket index, so the
+ * probe of the position gives a false hit with the probability
+ * of about TT_BUCKET_ENTRY_COUNT / 2^20 (1 in 131K probes)
+ */
+typedef uint64_t TTEntry;
+
+struct TTBucket
+{
+	TTEntry entries[TT_BUCKET_ENTRY_COUNT];
+};
 
 class TranspositionTable
 {
 public:
-	TranspositionTable();
-	
-	bool contains(const PositionState& pos, EvalInfo& eval) const;
+	explicit TranspositionTable(unsigned int sizeMB = TT_DEFAULT_SIZE_MB);
+	~TranspositionTable();
+
+	// Reallocates the table to have sizeMB megabytes,
+	// all the stored entries are lost
+	void resize(unsigned int sizeMB);
+
+	// Removes all the stored entries, large tables are
+	// cleared by several threads in parallel
+	void clear();
+
+	unsigned int sizeMB() const {return _sizeMB;}
+
+	// Starts the new generation of the entries, should be called
+	// before each search, so that the entries of the previous
+	// searches are replaced first
+	void newSearch() {_generation = (_generation + 1) % TT_GENERATION_COUNT;}
+
+	// Approximate permill of the entries stored by the current
+	// search, counted over the first buckets of the table
+	unsigned int hashfull() const;
+
+	// The found entry of the previous search gets the
+	// current age, as it is still useful
+	bool contains(const PositionState& pos, EvalInfo& eval);
+
+	// Starts loading the bucket of the position into the cache,
+	// so that the following probe of the position does not wait
+	void prefetch(ZobKey zobKey) const {__builtin_prefetch(getBucket(zobKey));}
 	
 	/**
 	 * override existing eval value if position is different,
-	 * or position is the same but the depth is bigger
+	 * or position is the same but the depth is bigger or
+	 * the existing value is from the previous search
+	 * The move of the eval is expected to be the best move
+	 * or the refutation move, only its from, to and promoted
+	 * fields are stored, the move type should be restored
+	 * by the user
 	 */
 	void push(const EvalInfo& eval);
 
@@ -26,10 +90,32 @@ public:
 	void forcePush(const EvalInfo& eval);
 
 private:
-	unsigned int hashFunction(const ZobKey& zobKey) const;
+	TranspositionTable(const TranspositionTable&); // non-copyable
+	TranspositionTable& operator=(const TranspositionTable&); // non-assignable
+
+	TTBucket* getBucket(const ZobKey& zobKey) const {return _buckets + (zobKey & _bucketMask);}
+
+	// Returns the entry of the bucket which should be replaced
+	// by the new position
+	TTEntry* replacementEntry(TTBucket* bucket) const;
+
+	// The bigger is the value, the more the entry should be kept
+	int entryWorth(TTEntry entry) const;
+
+	void allocate(unsigned int sizeMB);
+	void deallocate();
+
+	TTEntry packEntry(const EvalInfo& eval) const;
+	void unpackEntry(TTEntry entry, EvalInfo& eval) const;
+	uint16_t packMove(const MoveInfo& move) const;
+	MoveInfo unpackMove(uint16_t move) const;
 
 private:
-	std::vector<EvalInfo> _hash; 
+	TTBucket* _buckets;
+	std::size_t _bucketCount;
+	ZobKey _bucketMask;
+	unsigned int _sizeMB;
+	unsigned int _generation;
 };
 
 }
@@ -3,8 +3,15 @@
 #include <cstring>
 #include <mutex>
 #include <condition_variable>
+#include <atomic>
 #include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <sstream>
 #include "ABCore.h"
+#include "TranspositionTable.h"
 #include "PositionState.h"
 #include "MemPool.h"
 
@@ -13,22 +20,350 @@ namespace pismo
 namespace UCI
 {
 unsigned int PROGRAM_VERSION = 1;
-unsigned int MAX_COMMAND_SIZE = 100;
+// Commands of any length are read by the chunks of this size
+const int COMMAND_CHUNK_SIZE = 256;
+// Size of the info line without the moves of pv
+const int MAX_INFO_SIZE = 256;
 
 std::mutex searchMtx;
 std::mutex stopMtx;
 std::condition_variable searchCV;
 std::condition_variable stopCV;
 bool doSearch = false;
-bool stopSearch = false;
+// Set by quit command (or the end of the input) to finish
+// the search and timer threads
+bool quitUCI = false;
+// Polled by the search without locking, changed under stopMtx
+std::atomic<bool> stopSearch(false);
+
+// Default number of moves to the next time control
+// if movestogo is not given
+const unsigned int DEFAULT_MOVES_TO_GO = 30;
+
+// The hard limit is at most HARD_LIMIT_FACTOR times the soft limit
+const unsigned int HARD_LIMIT_FACTOR = 4;
+
+const unsigned int DEFAULT_MOVE_OVERHEAD = 30;
+const unsigned int MAX_MOVE_OVERHEAD = 5000;
+
+// Time reserved for the communication with GUI in milliseconds
+unsigned int moveOverhead = DEFAULT_MOVE_OVERHEAD;
+
+// Limits of the current search, time limits are in milliseconds
+// from the search start (0 if there is no limit), the search is
+// stopped by the timer after the hard limit
+uint16_t depthLimit = MAX_SEARCH_DEPTH - 1;
+unsigned int softTimeLimit = 0;
+unsigned int hardTimeLimit = 0;
+unsigned int nodeLimit = 0;
+// The infinite search (go infinite or go without parameters)
+// prints its move only after stop, even if it finishes earlier
+bool infiniteSearch = false;
+std::chrono::steady_clock::time_point searchStartTime;
 
 ABCore* engine = new ABCore();
 PositionState* pos = new PositionState();
 
+const char* START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Positions searched by the bench command
+const char* BENCH_FENS[] = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+	"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+	"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+	"8/7p/p5pb/4k3/P1pPn3/8/P5PP/1rB2RK1 b - d3 0 28",
+	"r3k2r/1b4bq/8/8/8/8/7B/R3K2R w KQkq - 0 1",
+	"n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+	"8/3K4/2p5/p2b2r1/5k2/8/8/1q6 b - - 1 67"
+};
+
+// FEN and the moves of the last position command, pos is the
+// position after the moves, so that the next position command
+// of the game makes only the new moves
+std::string positionFen = START_FEN;
+std::vector<std::string> positionMoves;
+
 enum SetOption {
-	DEBUG_LOG = 0, HASH, CLEAR_HASH, UNKNOWN
+	DEBUG_LOG = 0, HASH, CLEAR_HASH, THREADS, MOVE_OVERHEAD, UNKNOWN
 };
 
+// Parses "setoption name <id> [value <x>]" command
+// and sets value to the numeric value of the option if any
+SetOption parseOption(const char* command, unsigned int& value)
+{
+	const char* name = std::strstr(command, "name ");
+	if (!name) {
+		return UNKNOWN;
+	}
+	name += std::strlen("name ");
+	const char* valuePos = std::strstr(name, " value ");
+	std::size_t nameSize = valuePos ? valuePos - name : std::strcspn(name, "\r\n");
+	if (valuePos) {
+		value = std::strtoul(valuePos + std::strlen(" value "), 0, 10);
+	}
+
+	if (nameSize == std::strlen("Debug Log") && !std::strncmp(name, "Debug Log", nameSize)) {
+		return DEBUG_LOG;
+	}
+	else if (nameSize == std::strlen("Hash") && !std::strncmp(name, "Hash", nameSize)) {
+		return HASH;
+	}
+	else if (nameSize == std::strlen("Clear Hash") && !std::strncmp(name, "Clear Hash", nameSize)) {
+		return CLEAR_HASH;
+	}
+	else if (nameSize == std::strlen("Threads") && !std::strncmp(name, "Threads", nameSize)) {
+		return THREADS;
+	}
+	else if (nameSize == std::strlen("Move Overhead") && !std::strncmp(name, "Move Overhead", nameSize)) {
+		return MOVE_OVERHEAD;
+	}
+
+	return UNKNOWN;
+}
+
+// Finds " <name> <value>" in go command and sets value,
+// returns false if the parameter is not given
+bool parseGoParameter(const char* command, const char* name, unsigned int& value)
+{
+	std::size_t nameSize = std::strlen(name);
+	const char* param = command;
+	while ((param = std::strstr(param, name))) {
+		if (param[-1] == ' ' && param[nameSize] == ' ') {
+			value = std::strtoul(param + nameSize, 0, 10);
+			return true;
+		}
+		param += nameSize;
+	}
+
+	return false;
+}
+
+// Sets the limits of the search according to go command parameters:
+// the search is infinite only if it is requested or go has no parameters,
+// mate in n moves limits the depth to 2n plies, movetime is used as
+// the hard limit, with the remaining time the soft limit is the equal
+// share of the time for the moves to go plus the most of the increment
+void setSearchLimits(const char* command)
+{
+	depthLimit = MAX_SEARCH_DEPTH - 1;
+	softTimeLimit = 0;
+	hardTimeLimit = 0;
+	nodeLimit = 0;
+	infiniteSearch = false;
+
+	unsigned int value = 0;
+	if (parseGoParameter(command, "depth", value) && value > 0 && value < depthLimit) {
+		depthLimit = value;
+	}
+	if (parseGoParameter(command, "mate", value) && value > 0 && value < depthLimit / 2) {
+		depthLimit = 2 * value;
+	}
+	if (parseGoParameter(command, "nodes", value)) {
+		nodeLimit = std::max(value, 1u);
+	}
+	if (std::strstr(command, " infinite ") || !std::strcmp(command, "go ")) {
+		infiniteSearch = true;
+		return;
+	}
+	if (parseGoParameter(command, "movetime", value)) {
+		hardTimeLimit = value > moveOverhead ? value - moveOverhead : 1;
+		return;
+	}
+
+	unsigned int time = 0;
+	if (!parseGoParameter(command, pos->whiteToPlay() ? "wtime" : "btime", time)) {
+		return;
+	}
+	unsigned int increment = 0;
+	parseGoParameter(command, pos->whiteToPlay() ? "winc" : "binc", increment);
+	unsigned int movesToGo = DEFAULT_MOVES_TO_GO;
+	if (parseGoParameter(command, "movestogo", value) && value > 0 && value < DEFAULT_MOVES_TO_GO) {
+		movesToGo = value;
+	}
+
+	unsigned int availableTime = time > moveOverhead ? time - moveOverhead : 1;
+	softTimeLimit = std::min(availableTime / movesToGo + increment * 3 / 4, availableTime / 2);
+	hardTimeLimit = std::min(softTimeLimit * HARD_LIMIT_FACTOR, availableTime * 4 / 5);
+	softTimeLimit = std::max(softTimeLimit, 1u);
+	hardTimeLimit = std::max(hardTimeLimit, softTimeLimit);
+}
+
+// Reads the line of any length from stdin without the trailing
+// newline, returns false at the end of the input
+bool readCommand(std::string& command)
+{
+	command.clear();
+	char chunk[COMMAND_CHUNK_SIZE];
+	while (std::fgets(chunk, COMMAND_CHUNK_SIZE, stdin)) {
+		command += chunk;
+		if (command[command.size() - 1] == '\n') {
+			break;
+		}
+	}
+	if (command.empty()) {
+		return false;
+	}
+
+	command.erase(command.find_last_not_of("\r\n") + 1);
+	return true;
+}
+
+// Parses "position [startpos | fen <fen>] [moves <move> ...]" command,
+// the move counters of the FEN may be omitted, returns false
+// if the command is not valid
+bool parsePosition(const std::string& command, std::string& fen, std::vector<std::string>& moves)
+{
+	std::istringstream commandStream(command);
+	std::string token;
+	commandStream >> token;
+	if (!(commandStream >> token)) {
+		return false;
+	}
+
+	if (token == "startpos") {
+		fen = START_FEN;
+		commandStream >> token;
+	}
+	else if (token == "fen") {
+		fen.clear();
+		unsigned int fieldCount = 0;
+		while (commandStream >> token && token != "moves") {
+			if (fieldCount++) {
+				fen += ' ';
+			}
+			fen += token;
+		}
+		if (fieldCount < 4 || fieldCount > 6) {
+			return false;
+		}
+		if (fieldCount == 4) {
+			fen += " 0";
+		}
+		if (fieldCount < 6) {
+			fen += " 1";
+		}
+	}
+	else {
+		return false;
+	}
+
+	moves.clear();
+	if (token == "moves") {
+		while (commandStream >> token) {
+			moves.push_back(token);
+		}
+	}
+
+	return true;
+}
+
+// Converts the move from long algebraic notation (e.g. "e7e8q")
+// and fills its type, returns false if the move is not legal in pos
+bool parseMove(const std::string& str, MoveInfo& move)
+{
+	if (str.size() < 4 || str.size() > 5 ||
+			str[0] < 'a' || str[0] > 'h' || str[1] < '1' || str[1] > '8' ||
+			str[2] < 'a' || str[2] > 'h' || str[3] < '1' || str[3] > '8') {
+		return false;
+	}
+
+	move = MoveInfo((Square) ((str[1] - '1') * 8 + str[0] - 'a'), (Square) ((str[3] - '1') * 8 + str[2] - 'a'));
+	if (str.size() == 5) {
+		switch (str[4]) {
+			case 'q':
+				move.promoted = pos->whiteToPlay() ? QUEEN_WHITE : QUEEN_BLACK;
+				break;
+			case 'r':
+				move.promoted = pos->whiteToPlay() ? ROOK_WHITE : ROOK_BLACK;
+				break;
+			case 'b':
+				move.promoted = pos->whiteToPlay() ? BISHOP_WHITE : BISHOP_BLACK;
+				break;
+			case 'n':
+				move.promoted = pos->whiteToPlay() ? KNIGHT_WHITE : KNIGHT_BLACK;
+				break;
+			default:
+				return false;
+		}
+	}
+
+	pos->initCheckPinInfo(0);
+	return pos->moveIsPseudoLegal(move) && pos->pseudoMoveIsLegalMove(move);
+}
+
+// Brings pos to the position after the moves from fen: if fen is
+// the same as the one of the last position command, the moves which
+// differ from the last ones are undone and only the new moves are made,
+// otherwise the position is initialized from fen, the search should
+// not be running
+void setPosition(const std::string& fen, const std::vector<std::string>& moves)
+{
+	std::size_t commonMoveCount = 0;
+	if (fen == positionFen) {
+		while (commonMoveCount < positionMoves.size() && commonMoveCount < moves.size() &&
+				positionMoves[commonMoveCount] == moves[commonMoveCount]) {
+			++commonMoveCount;
+		}
+		while (positionMoves.size() > commonMoveCount) {
+			pos->undoMove();
+			positionMoves.pop_back();
+		}
+	}
+	else {
+		pos->initPositionFEN(fen);
+		positionFen = fen;
+		positionMoves.clear();
+	}
+
+	for (std::size_t i = commonMoveCount; i < moves.size(); ++i) {
+		MoveInfo move;
+		if (!parseMove(moves[i], move)) {
+			std::fprintf(stdout, "info string Illegal move %s\n", moves[i].c_str());
+			std::fflush(stdout);
+			break;
+		}
+		pos->makeMove(move);
+		positionMoves.push_back(moves[i]);
+	}
+}
+
+// Stops the running search (if any) and waits until
+// its move is printed
+void stopSearchAndWait()
+{
+	std::unique_lock<std::mutex> timerLck(stopMtx);
+	stopSearch = true;
+	stopCV.notify_all();
+	stopCV.wait(timerLck, []() {return !doSearch;});
+}
+
+void bench(uint16_t depth, unsigned int hashSize)
+{
+	ABCore benchEngine;
+	benchEngine.setHashSize(hashSize);
+	PositionState benchPos;
+	uint64_t totalNodeCount = 0;
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	for (std::size_t i = 0; i < sizeof(BENCH_FENS) / sizeof(BENCH_FENS[0]); ++i) {
+		benchEngine.clearHash();
+		benchPos.initPositionFEN(BENCH_FENS[i]);
+		MoveInfo move = benchEngine.think(benchPos, depth);
+		std::fprintf(stdout, "Position %u: bestmove %s nodes %llu\n", (unsigned int) i + 1,
+				moveToUCINotation(move).c_str(), (unsigned long long) benchEngine.nodeCount());
+		totalNodeCount += benchEngine.nodeCount();
+	}
+	uint64_t time = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - startTime).count();
+
+	std::fprintf(stdout, "\nTotal time (ms) : %llu\nNodes searched  : %llu\nNodes/second    : %llu\n",
+			(unsigned long long) time, (unsigned long long) totalNodeCount,
+			(unsigned long long) (totalNodeCount * 1000 / (time ? time : 1)));
+	std::fflush(stdout);
+}
+
 void initUCI()
 {
 	std::fputs("id name Pismo ", stdout);
@@ -36,10 +371,14 @@ void initUCI()
 	std::fputc('\n', stdout);
 	std::fputs("id author Harut Movsisyan and Areg Ghazaryan\n\n", stdout);
 	std::fputs("option name Debug Log type check defualt false\n", stdout);
-	std::fputs("option name Hash type spin default 8 min 1 max 128\n", stdout);
+	std::fprintf(stdout, "option name Hash type spin default %u min %u max %u\n", TT_DEFAULT_SIZE_MB, TT_MIN_SIZE_MB, TT_MAX_SIZE_MB);
 	std::fputs("option name Clear Hash type button\n", stdout);
+	std::fprintf(stdout, "option name Threads type spin default 1 min 1 max %u\n", MAX_THREAD_COUNT);
+	std::fprintf(stdout, "option name Move Overhead type spin default %u min 0 max %u\n", DEFAULT_MOVE_OVERHEAD, MAX_MOVE_OVERHEAD);
 	std::fputs("uciok\n", stdout);
-	pos->initPositionFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+	std::fflush(stdout);
+	engine->setInfoOutput(true);
+	pos->initPositionFEN(START_FEN);
 }
 
 void manageUCI()
@@ -47,98 +386,191 @@ void manageUCI()
 	initUCI();
 	MemPool::initMoveGenInfo();
 	MemPool::initCheckPinInfo();
-	//const char* delimiter = " \t";
-	char command[MAX_COMMAND_SIZE];
-	while (fgets(command, MAX_COMMAND_SIZE, stdin)) {
-		//char* part = std::strtok(command, delimiter);
-		if (!std::strcmp(command, "isready\n")) {
+	std::string command;
+	while (readCommand(command)) {
+		if (command == "isready") {
 			std::fputs("readyok\n", stdout);
+			std::fflush(stdout);
 		}
-		/*else if (std::strcmp(command, "setoption")) {
+		else if (!command.compare(0, std::strlen("setoption"), "setoption")) {
 			unsigned int value = 0;
-			SetOption option = parseOption(value);
+			SetOption option = parseOption(command.c_str(), value);
+			// options are changed only when the search is not running,
+			// manageSearch holds searchMtx until the search is finished
+			stopSearchAndWait();
+			std::unique_lock<std::mutex> searchLck(searchMtx);
 			switch(option) {
 				case DEBUG_LOG:
 					break;
-				case HASH_SIZE:
+				case HASH:
+					engine->setHashSize(value);
 					break;
 				case CLEAR_HASH:
+					engine->clearHash();
+					break;
+				case THREADS:
+					engine->setThreadCount(value);
+					break;
+				case MOVE_OVERHEAD:
+					moveOverhead = std::min(value, MAX_MOVE_OVERHEAD);
 					break;
 				case UNKNOWN:
 					std::fputs("Unknown option:\n", stdout);
 			}
-		}*/
-		else if (!std::strncmp(command, "position", std::strlen("position"))) {
-			if (!std::strcmp(command, "position startpos\n")) {
-				std::unique_lock<std::mutex> timerLck(stopMtx);
-				stopSearch = true;
-				stopCV.wait(timerLck, []() {return !doSearch;});
-				pos->initPositionFEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+		}
+		else if (command == "ucinewgame") {
+			// the transposition table is kept between
+			// the moves of the game, but not between the games
+			stopSearchAndWait();
+			std::unique_lock<std::mutex> searchLck(searchMtx);
+			engine->clearHash();
+		}
+		else if (!command.compare(0, std::strlen("position "), "position ")) {
+			std::string fen;
+			std::vector<std::string> moves;
+			if (parsePosition(command, fen, moves)) {
+				stopSearchAndWait();
+				setPosition(fen, moves);
 			}
 		}
-		else if (!std::strcmp(command, "go\n")) {
+		else if (command == "go" || !command.compare(0, std::strlen("go "), "go ")) {
+			stopSearchAndWait();
 			std::unique_lock<std::mutex> searchLck(searchMtx);
 			std::unique_lock<std::mutex> timerLck(stopMtx);
+			// the search line is parsed with spaces around each token
+			setSearchLimits((command + ' ').c_str());
+			searchStartTime = std::chrono::steady_clock::now();
 			doSearch = true;
 			stopSearch = false;
 			stopCV.notify_one();
 			searchCV.notify_one();
 		}
-		else if (!std::strcmp(command, "quit\n")) {
-			std::exit(EXIT_SUCCESS);
+		else if (command == "stop") {
+			std::unique_lock<std::mutex> timerLck(stopMtx);
+			stopSearch = true;
+			stopCV.notify_all();
+		}
+		else if (command == "quit") {
+			break;
 		}
 	}
+
+	stopSearchAndWait();
+	std::unique_lock<std::mutex> searchLck(searchMtx);
+	std::unique_lock<std::mutex> timerLck(stopMtx);
+	quitUCI = true;
+	searchCV.notify_one();
+	stopCV.notify_all();
+	timerLck.unlock();
+	searchLck.unlock();
+
 	MemPool::destroyMoveGenInfo();
 	MemPool::destroyCheckPinInfo();
 }
 
 void manageSearch()
 {
+	MemPool::initMoveGenInfo();
+	MemPool::initCheckPinInfo();
 	std::unique_lock<std::mutex> searchLck(searchMtx);
 	while (true) {
-		searchCV.wait(searchLck, []() {return doSearch;});
-		MoveInfo move = engine->think(*pos, 8);
+		searchCV.wait(searchLck, []() {return doSearch || quitUCI;});
+		if (quitUCI) {
+			break;
+		}
+		MoveInfo move = engine->think(*pos, depthLimit, softTimeLimit, infiniteSearch, nodeLimit);
+		std::unique_lock<std::mutex> timerLck(stopMtx);
+		if (infiniteSearch) {
+			// the search reached the depth limit before stop
+			stopCV.wait(timerLck, []() {return stopSearch.load();});
+		}
 		printMove(move);
 		doSearch = false;
+		timerLck.unlock();
 		stopCV.notify_all();
 	}
+	MemPool::destroyMoveGenInfo();
+	MemPool::destroyCheckPinInfo();
 }
 
 void manageTimer()
 {
 	std::unique_lock<std::mutex> timerLck(stopMtx);
 	while (true) {
-		stopCV.wait(timerLck, []() {return doSearch;});
-		timerLck.unlock();
-		auto startTime = std::chrono::steady_clock::now();
-		bool elapsed = false;
-		while (!elapsed) {
-			auto endTime = std::chrono::steady_clock::now();
-			if (std::chrono::duration_cast<std::chrono::seconds>(endTime - startTime).count() 
-					== 10) {
-				elapsed = true;
+		stopCV.wait(timerLck, []() {return doSearch || quitUCI;});
+		if (quitUCI) {
+			break;
+		}
+		if (hardTimeLimit) {
+			// sleeps until the hard limit or the end of the search
+			std::chrono::steady_clock::time_point stopTime = searchStartTime + std::chrono::milliseconds(hardTimeLimit);
+			if (!stopCV.wait_until(timerLck, stopTime, []() {return !doSearch;})) {
+				stopSearch = true;
 			}
 		}
-		timerLck.lock();
-		stopSearch = true;
 		stopCV.wait(timerLck, []() {return !doSearch;});
 	}
 }
 
+// Null move is "0000"
+std::string moveToUCINotation(const MoveInfo& move)
+{
+	if (move.from == INVALID_SQUARE) {
+		return "0000";
+	}
+
+	std::string str;
+	str += 'a' + move.from % 8;
+	str += '1' + move.from / 8;
+	str += 'a' + move.to % 8;
+	str += '1' + move.to / 8;
+	str += getPromoted(move.promoted);
+	return str;
+}
+
 void printMove(const MoveInfo& move)
 {
-	std::fputs("bestmove ", stdout);
-	if (move.from != INVALID_SQUARE) {
-		std::fputc('a' + move.from % 8, stdout);
-		std::fputc('1' + move.from / 8, stdout);
-		std::fputc('a' + move.to % 8, stdout);
-		std::fputc('1' + move.to / 8, stdout);
-		std::fputs(getPromoted(move.promoted).c_str(), stdout);
+	std::fprintf(stdout, "bestmove %s\n", moveToUCINotation(move).c_str());
+	std::fflush(stdout);
+}
+
+// Mate scores are printed as the number of moves to the
+// mate, negative if the side to move is mated
+void printSearchInfo(uint16_t depth, uint16_t selDepth, int16_t score,
+		uint64_t nodeCount, uint64_t time, unsigned int hashfull,
+		const MoveInfo* pv, uint16_t pvSize)
+{
+	char buffer[MAX_INFO_SIZE];
+	int size = std::snprintf(buffer, MAX_INFO_SIZE, "info depth %u seldepth %u", depth, selDepth);
+	if (isMateScore(score)) {
+		int mateMoves = (MAX_SCORE - std::abs(score) + 1) / 2;
+		size += std::snprintf(buffer + size, MAX_INFO_SIZE - size, " score mate %d", score > 0 ? mateMoves : -mateMoves);
 	}
 	else {
-		std::fputs("0000", stdout);
+		size += std::snprintf(buffer + size, MAX_INFO_SIZE - size, " score cp %d", score);
 	}
-	std::fputc('\n', stdout);
+	size += std::snprintf(buffer + size, MAX_INFO_SIZE - size,
+			" nodes %llu nps %llu hashfull %u time %llu pv",
+			(unsigned long long) nodeCount, (unsigned long long) (nodeCount * 1000 / (time ? time : 1)),
+			hashfull, (unsigned long long) time);
+
+	// the line is printed at once, so that it is not mixed
+	// with the output of the other thread
+	std::string line(buffer, size);
+	for (uint16_t i = 0; i < pvSize; ++i) {
+		line += ' ';
+		line += moveToUCINotation(pv[i]);
+	}
+	line += '\n';
+	std::fputs(line.c_str(), stdout);
+	std::fflush(stdout);
+}
+
+void printCurrentMove(uint16_t depth, const MoveInfo& move, unsigned int moveNumber)
+{
+	std::fprintf(stdout, "info depth %u currmove %s currmovenumber %u\n",
+			depth, moveToUCINotation(move).c_str(), moveNumber);
+	std::fflush(stdout);
 }
 
 }
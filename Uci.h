@@ -2,6 +2,7 @@
 #define UCI_H_
 
 #include "utils.h"
+#include <string>
 
 namespace pismo
 {
@@ -14,6 +15,13 @@ namespace UCI
 	 */
 	void initUCI();
 
+	/* Searches the fixed set of positions to the depth
+	   with one thread and the hash of hashSize MB (cleared
+	   before each position), prints the nodes and the speed,
+	   the node count changes only if the search changes
+	 */
+	void bench(uint16_t depth, unsigned int hashSize);
+
 	/* Manages UCI by listening to
 	   stdin and executing the commands
 	   coming from GUI
@@ -32,11 +40,29 @@ namespace UCI
 	   */
 	void manageTimer();
 
+	/* Returns the move in long algebraic
+	   notation used by UCI (e.g. "e7e8q")
+	*/
+	std::string moveToUCINotation(const MoveInfo& move);
+
 	/* Prints move to stdout according to 
 	   UCI format
 	*/
 	void printMove(const MoveInfo& move);
 
+	/* Prints the result of the finished search
+	   iteration to stdout as UCI info line,
+	   time is in milliseconds
+	*/
+	void printSearchInfo(uint16_t depth, uint16_t selDepth, int16_t score,
+			uint64_t nodeCount, uint64_t time, unsigned int hashfull,
+			const MoveInfo* pv, uint16_t pvSize);
+
+	/* Prints the root move which is currently
+	   searched to stdout as UCI info line
+	*/
+	void printCurrentMove(uint16_t depth, const MoveInfo& move, unsigned int moveNumber);
+
 }
 
 }
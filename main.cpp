@@ -8,16 +8,23 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <cctype>
 
 void printBitboard(const pismo::Bitboard& board);
 pismo::Piece getPromoted(const std::string& piece);
 
 
 const unsigned int MAX_COMMAND_SIZE = 100;
+const unsigned int DEFAULT_BENCH_DEPTH = 10;
+const unsigned int DEFAULT_BENCH_HASH_SIZE = 16;
 
 int main()
 {
 	using namespace pismo;
+	if (!cpuSupportsBuild()) {
+		std::fprintf(stderr, "The CPU does not support the instructions of this build, rebuild with make ARCH=dispatch or ARCH=generic\n");
+		return 1;
+	}
 	char command[MAX_COMMAND_SIZE];
 	while (std::fgets(command, MAX_COMMAND_SIZE, stdin)) {
 		if (!std::strcmp(command, "uci\n")) {
@@ -26,6 +33,19 @@ int main()
 		UCI::manageUCI();
 		searchThread.join();
 		timerThread.join();
+		break;
+		}
+		else if (!std::strncmp(command, "bench", std::strlen("bench")) && std::isspace(command[5])) {
+			// bench [depth] [hash]
+			unsigned int depth = DEFAULT_BENCH_DEPTH;
+			unsigned int hashSize = DEFAULT_BENCH_HASH_SIZE;
+			std::sscanf(command + 5, "%u %u", &depth, &hashSize);
+			MemPool::initMoveGenInfo();
+			MemPool::initCheckPinInfo();
+			UCI::bench(depth, hashSize);
+			MemPool::destroyMoveGenInfo();
+			MemPool::destroyCheckPinInfo();
+			break;
 		}
 		else if (!std::strcmp(command, "nouci\n")) {
 			std::map<std::string, Square> boardRep;
@@ -0,0 +1,286 @@
+#include "PositionState.h"
+#include "MoveGenerator.h"
+#include "PositionEvaluation.h"
+#include "BitboardImpl.h"
+#include "MemPool.h"
+#include "SliderAttacks.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+
+// Microbenchmarks of the hot paths of the engine: each operation
+// is run on all the positions (or moves) of the corpus built from
+// the input file, first WARMUP_ITERATIONS times without measuring
+// and then the given number of iterations, the time per operation
+// and the number of operations per second are printed
+
+const unsigned int DEFAULT_ITERATIONS = 1000;
+const unsigned int WARMUP_ITERATIONS = 100;
+
+// Each position of the corpus keeps its check and pin info in
+// its own depth of the memory pool, so that the moves of all
+// the positions can be made without initializing it again
+const std::size_t MAX_CORPUS_SIZE = pismo::MAX_SEARCH_DEPTH - 1;
+
+const char* MOVE_TYPE_NAMES[] = {"normal", "capture", "promotion", "castling", "double push", "en passant"};
+
+struct CorpusMove
+{
+	std::size_t posIndex;
+	pismo::MoveInfo move;
+};
+
+// Keeps the results of the measured operations, so
+// that the compiler does not remove them
+volatile uint64_t resultSink = 0;
+
+// Input lines are in the perft positions format (FEN followed
+// by perft depth and move count), only the FEN part is used
+std::string parseFen(const std::string& line)
+{
+	std::istringstream lineStream(line);
+	std::string fen;
+	std::string field;
+	for (unsigned int i = 0; i < 6 && lineStream >> field; ++i) {
+		if (i != 0) {
+			fen.push_back(' ');
+		}
+		fen.append(field);
+	}
+
+	return fen;
+}
+
+// Runs op (which does opCount operations) warmup and measured
+// iterations and prints the time of one operation
+template <typename Op>
+void runBench(const std::string& name, unsigned int iterations, uint64_t opCount, Op op)
+{
+	std::cout << std::left << std::setw(32) << name;
+	if (!opCount) {
+		std::cout << "no operations in the corpus" << std::endl;
+		return;
+	}
+
+	for (unsigned int i = 0; i < WARMUP_ITERATIONS; ++i) {
+		op();
+	}
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (unsigned int i = 0; i < iterations; ++i) {
+		op();
+	}
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+	double nsPerOp = std::chrono::duration<double, std::nano>(end - start).count() / ((double) iterations * opCount);
+	std::cout << std::right << std::fixed << std::setprecision(1) << std::setw(10) << nsPerOp << " ns/op"
+		<< std::setprecision(0) << std::setw(14) << 1e9 / nsPerOp << " ops/sec" << std::endl;
+}
+
+// Runs the rook and bishop attacks of the slider attacks backend
+// from every square of every position of the corpus
+template <typename Backend>
+void runSliderBench(const std::string& name, const Backend& backend,
+		const std::vector<pismo::PositionState>& positions, unsigned int iterations)
+{
+	runBench(name + " rook attacks", iterations, positions.size() * pismo::SQUARES_COUNT, [&]() {
+		for (std::size_t i = 0; i < positions.size(); ++i) {
+			for (unsigned int sq = 0; sq < pismo::SQUARES_COUNT; ++sq) {
+				resultSink += backend.rookAttacks((pismo::Square) sq, positions[i].occupiedSquares());
+			}
+		}
+	});
+	runBench(name + " bishop attacks", iterations, positions.size() * pismo::SQUARES_COUNT, [&]() {
+		for (std::size_t i = 0; i < positions.size(); ++i) {
+			for (unsigned int sq = 0; sq < pismo::SQUARES_COUNT; ++sq) {
+				resultSink += backend.bishopAttacks((pismo::Square) sq, positions[i].occupiedSquares());
+			}
+		}
+	});
+}
+
+// Collects the legal moves of the position
+void collectLegalMoves(pismo::PositionState& pos, std::size_t posIndex, std::vector<CorpusMove>& moves)
+{
+	uint16_t depth = posIndex + 1;
+	pos.initCheckPinInfo(depth);
+	pismo::MoveGenerator::instance()->generatePerftMoves(pos, depth);
+	pismo::MoveGenInfo* genInfo = pismo::MemPool::getMoveGenInfo(depth);
+	for (uint16_t i = 0; i < genInfo->_availableMovesSize; ++i) {
+		if (pos.pseudoMoveIsLegalMove(genInfo->_availableMoves[i])) {
+			CorpusMove corpusMove = {posIndex, genInfo->_availableMoves[i]};
+			moves.push_back(corpusMove);
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 2 && argc != 3) {
+		std::cout << "\nUsage:\n     " << argv[0] << " input_file [iterations]\n" << std::endl;
+		return 1;
+	}
+
+	std::ifstream ifStream(argv[1]);
+	if (!ifStream.is_open()) {
+		std::cout << "Cannot open the " << argv[1] << " file for reading" << std::endl;
+		return 1;
+	}
+	unsigned int iterations = argc == 3 ? std::atoi(argv[2]) : DEFAULT_ITERATIONS;
+
+	pismo::MemPool::initMoveGenInfo();
+	pismo::MemPool::initCheckPinInfo();
+	pismo::MoveGenerator* moveGen = pismo::MoveGenerator::instance();
+
+	std::vector<pismo::PositionState> positions;
+	std::string line;
+	while (std::getline(ifStream, line) && positions.size() < MAX_CORPUS_SIZE) {
+		if (!line.empty()) {
+			positions.push_back(pismo::PositionState());
+			positions.back().initPositionFEN(parseFen(line));
+		}
+	}
+
+	// The positions after the checking moves of the input
+	// positions are added for the evasion benchmark
+	std::size_t inputSize = positions.size();
+	for (std::size_t i = 0; i < inputSize && positions.size() < MAX_CORPUS_SIZE; ++i) {
+		std::vector<CorpusMove> moves;
+		collectLegalMoves(positions[i], i, moves);
+		for (std::size_t j = 0; j < moves.size() && positions.size() < MAX_CORPUS_SIZE; ++j) {
+			positions[i].makeMove(moves[j].move);
+			if (positions[i].kingUnderCheck()) {
+				positions.push_back(pismo::PositionState());
+				positions.back().initPositionFEN(positions[i].getStateFEN());
+			}
+			positions[i].undoMove();
+			positions[i].updateCheckPinInfo(i + 1);
+		}
+	}
+
+	std::vector<std::size_t> quietPositions;
+	std::vector<std::size_t> checkPositions;
+	std::vector<CorpusMove> movesByType[pismo::NULL_MOVE];
+	std::vector<CorpusMove> captures;
+	for (std::size_t i = 0; i < positions.size(); ++i) {
+		std::vector<CorpusMove> moves;
+		collectLegalMoves(positions[i], i, moves);
+		for (std::size_t j = 0; j < moves.size(); ++j) {
+			movesByType[moves[j].move.type].push_back(moves[j]);
+		}
+		if (positions[i].kingUnderCheck()) {
+			checkPositions.push_back(i);
+		}
+		else {
+			quietPositions.push_back(i);
+			uint16_t captureCount = moveGen->generateStageMoves(positions[i], i + 1, pismo::GOOD_CAPTURING_MOVES);
+			pismo::MoveGenInfo* genInfo = pismo::MemPool::getMoveGenInfo(i + 1);
+			for (uint16_t j = 0; j < captureCount; ++j) {
+				if (genInfo->_availableMoves[j].type != pismo::PROMOTION_MOVE) {
+					CorpusMove capture = {i, genInfo->_availableMoves[j]};
+					captures.push_back(capture);
+				}
+			}
+		}
+	}
+
+	std::cout << "Corpus: " << positions.size() << " positions (" << checkPositions.size()
+		<< " in check), " << iterations << " iterations\n" << std::endl;
+
+	for (unsigned int type = 0; type < pismo::NULL_MOVE; ++type) {
+		const std::vector<CorpusMove>& moves = movesByType[type];
+		runBench(std::string("makeMove/undoMove ") + MOVE_TYPE_NAMES[type], iterations, moves.size(), [&]() {
+			for (std::size_t i = 0; i < moves.size(); ++i) {
+				pismo::PositionState& pos = positions[moves[i].posIndex];
+				pos.makeMove(moves[i].move);
+				pos.undoMove();
+			}
+		});
+	}
+
+	runBench("initCheckPinInfo", iterations, positions.size(), [&]() {
+		for (std::size_t i = 0; i < positions.size(); ++i) {
+			positions[i].initCheckPinInfo(i + 1);
+		}
+	});
+
+	const pismo::MoveGenerationStage stages[] = {pismo::GOOD_CAPTURING_MOVES, pismo::CHECKING_MOVES, pismo::QUITE_MOVES};
+	const char* stageNames[] = {"generate capturing moves", "generate checking moves", "generate quite moves"};
+	for (unsigned int s = 0; s < sizeof(stages) / sizeof(stages[0]); ++s) {
+		runBench(stageNames[s], iterations, quietPositions.size(), [&]() {
+			for (std::size_t i = 0; i < quietPositions.size(); ++i) {
+				resultSink += moveGen->generateStageMoves(positions[quietPositions[i]], quietPositions[i] + 1, stages[s]);
+			}
+		});
+	}
+	runBench("generate evasion moves", iterations, checkPositions.size(), [&]() {
+		for (std::size_t i = 0; i < checkPositions.size(); ++i) {
+			resultSink += moveGen->generateStageMoves(positions[checkPositions[i]], checkPositions[i] + 1, pismo::EVASION_MOVES);
+		}
+	});
+
+	runBench("SEE", iterations, captures.size(), [&]() {
+		for (std::size_t i = 0; i < captures.size(); ++i) {
+			resultSink += moveGen->staticExchangeEval(positions[captures[i].posIndex], captures[i].move);
+		}
+	});
+
+	pismo::PositionEvaluation posEval;
+	posEval.initPosEval();
+	runBench("evaluate (eval hash hit)", iterations, positions.size(), [&]() {
+		for (std::size_t i = 0; i < positions.size(); ++i) {
+			resultSink += posEval.evaluate(positions[i]);
+		}
+	});
+	runBench("evaluate (warm pawn hash)", iterations, positions.size(), [&]() {
+		for (std::size_t i = 0; i < positions.size(); ++i) {
+			posEval.clearEvalEntry(positions[i]);
+			resultSink += posEval.evaluate(positions[i]);
+		}
+	});
+	runBench("evaluate (cold pawn hash)", iterations, positions.size(), [&]() {
+		for (std::size_t i = 0; i < positions.size(); ++i) {
+			posEval.clearEvalEntry(positions[i]);
+			posEval.clearPawnEntry(positions[i]);
+			resultSink += posEval.evaluate(positions[i]);
+		}
+	});
+
+	const pismo::BitboardImpl* bitboardImpl = pismo::BitboardImpl::instance();
+	runBench("rookAttackFrom", iterations, positions.size() * pismo::SQUARES_COUNT, [&]() {
+		for (std::size_t i = 0; i < positions.size(); ++i) {
+			for (unsigned int sq = 0; sq < pismo::SQUARES_COUNT; ++sq) {
+				resultSink += bitboardImpl->rookAttackFrom((pismo::Square) sq, positions[i].occupiedSquares());
+			}
+		}
+	});
+	runBench("bishopAttackFrom", iterations, positions.size() * pismo::SQUARES_COUNT, [&]() {
+		for (std::size_t i = 0; i < positions.size(); ++i) {
+			for (unsigned int sq = 0; sq < pismo::SQUARES_COUNT; ++sq) {
+				resultSink += bitboardImpl->bishopAttackFrom((pismo::Square) sq, positions[i].occupiedSquares());
+			}
+		}
+	});
+
+	// all the backends, the engine uses the one chosen at build time
+	pismo::MagicMovesSliders magicMoves;
+	runSliderBench("magicmoves", magicMoves, positions, iterations);
+	pismo::FancyMagicSliders fancyMagic;
+	runSliderBench("fancy magic", fancyMagic, positions, iterations);
+#ifdef __BMI2__
+	pismo::PextSliders pext;
+	runSliderBench("pext", pext, positions, iterations);
+#endif
+	pismo::KoggeStoneSliders koggeStone;
+	runSliderBench("kogge-stone", koggeStone, positions, iterations);
+
+	moveGen->destroy();
+	pismo::MemPool::destroyMoveGenInfo();
+	pismo::MemPool::destroyCheckPinInfo();
+
+	return 0;
+}
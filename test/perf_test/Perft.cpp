@@ -2,41 +2,159 @@
 #include "PositionState.h"
 #include "MoveGenerator.h"
 #include "MemPool.h"
+#include "Uci.h"
+#include <thread>
+#include <chrono>
 #include <iostream>
 
 namespace pismo
 {
 
-uint64_t Perft::analyze(PositionState& pos, uint16_t depth, bool begin) const
+uint64_t Perft::analyze(const PositionState& pos, uint16_t depth, bool divide)
 {
-	if (depth == 0) {
-		return 1;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	PositionState rootPos(pos);
+	_rootMoves.clear();
+	if (depth > 0) {
+		rootPos.initCheckPinInfo(depth);
+		MoveGenerator::instance()->generatePerftMoves(rootPos, depth);
+		MoveGenInfo* genInfo = MemPool::getMoveGenInfo(depth);
+		for (uint16_t i = 0; i < genInfo->_availableMovesSize; ++i) {
+			if (rootPos.pseudoMoveIsLegalMove(genInfo->_availableMoves[i])) {
+				_rootMoves.push_back(genInfo->_availableMoves[i]);
+			}
+		}
+	}
+	_rootCounts.assign(_rootMoves.size(), 0);
+	_nextRootMove = 0;
+
+	if (depth > 1) {
+		std::vector<std::thread> threads;
+		for (unsigned int i = 0; i < _threadCount; ++i) {
+			threads.push_back(std::thread(&Perft::analyzeRootMoves, this, std::cref(pos), depth));
+		}
+		for (std::size_t i = 0; i < threads.size(); ++i) {
+			threads[i].join();
+		}
+	}
+	else {
+		// the root moves are the leaves
+		_rootCounts.assign(_rootMoves.size(), 1);
+	}
+
+	uint64_t moveCount = depth == 0 ? 1 : 0;
+	for (std::size_t i = 0; i < _rootMoves.size(); ++i) {
+		moveCount += _rootCounts[i];
+		if (divide) {
+			std::cout << UCI::moveToUCINotation(_rootMoves[i]) << ": " << _rootCounts[i] << std::endl;
+		}
+	}
+
+	if (divide) {
+		uint64_t time = std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::steady_clock::now() - start).count();
+		std::cout << "\nNodes: " << moveCount << "\nTime: " << time << "ms\nNodes/sec: "
+			<< moveCount * 1000 / (time ? time : 1) << std::endl;
+	}
+
+	return moveCount;
+}
+
+void Perft::analyzeRootMoves(const PositionState& pos, uint16_t depth)
+{
+	MemPool::initMoveGenInfo();
+	MemPool::initCheckPinInfo();
+	PositionState threadPos(pos);
+	threadPos.initCheckPinInfo(depth);
+	std::size_t i;
+	while ((i = _nextRootMove++) < _rootMoves.size()) {
+		threadPos.makeMove(_rootMoves[i]);
+		_rootCounts[i] = countNodes(threadPos, depth - 1);
+		threadPos.undoMove();
+		threadPos.updateCheckPinInfo(depth);
 	}
+	MoveGenerator::instance()->destroy();
+	MemPool::destroyMoveGenInfo();
+	MemPool::destroyCheckPinInfo();
+}
 
+// The leaf moves are counted from the bitboards (not made),
+// the counts from depth 2 are stored in the perft hash
+uint64_t Perft::countNodes(PositionState& pos, uint16_t depth)
+{
 	pos.initCheckPinInfo(depth);
-	MoveGenerator::instance()->generatePerftMoves(pos, depth);
+	if (depth == 1) {
+		return MoveGenerator::instance()->countPerftMoves(pos, depth);
+	}
 
 	uint64_t moveCount = 0;
+	if (probeHash(pos.getZobKey(), depth, moveCount)) {
+		return moveCount;
+	}
+
+	MoveGenerator::instance()->generatePerftMoves(pos, depth);
+
 	MoveGenInfo* genInfo = MemPool::getMoveGenInfo(depth);
 	while (genInfo->_currentMovePos < genInfo->_availableMovesSize) {
-		uint64_t mc = 0;
-		if (pos.pseudoMoveIsLegalMove((genInfo->_availableMoves)[genInfo->_currentMovePos++])) {
-			pos.makeMove((genInfo->_availableMoves)[genInfo->_currentMovePos - 1]);
-			mc = analyze(pos, depth - 1);
+		const MoveInfo& move = (genInfo->_availableMoves)[genInfo->_currentMovePos++];
+		if (pos.pseudoMoveIsLegalMove(move)) {
+			pos.makeMove(move);
+			moveCount += countNodes(pos, depth - 1);
 			pos.undoMove();
 			pos.updateCheckPinInfo(depth);
 		}
-		moveCount += mc;
-		if (begin) {
-			//std::cout << "Move: " << pismo::moveToNotation((genInfo->_availableMoves)[genInfo->_currentMovePos - 1]) << "    " << mc << "   FEN: " << pos.getStateFEN() << std::endl;
-		}
 	}
 
+	storeHash(pos.getZobKey(), depth, moveCount);
 	return moveCount;
 }
 
-Perft::Perft()
+bool Perft::probeHash(ZobKey key, uint16_t depth, uint64_t& count) const
+{
+	if (_hash.empty()) {
+		return false;
+	}
+
+	const PerftEntry& entry = _hash[key & _hashMask];
+	uint64_t data = entry.data.load(std::memory_order_relaxed);
+	if ((entry.key.load(std::memory_order_relaxed) ^ data) != key || (data & 0xff) != depth) {
+		return false;
+	}
+
+	count = data >> 8;
+	return true;
+}
+
+void Perft::storeHash(ZobKey key, uint16_t depth, uint64_t count)
+{
+	if (_hash.empty()) {
+		return;
+	}
+
+	PerftEntry& entry = _hash[key & _hashMask];
+	uint64_t data = (count << 8) | depth;
+	entry.key.store(key ^ data, std::memory_order_relaxed);
+	entry.data.store(data, std::memory_order_relaxed);
+}
+
+Perft::Perft(unsigned int threadCount, unsigned int hashSize) :
+_threadCount(threadCount ? threadCount : 1),
+_hash(),
+_hashMask(0),
+_rootMoves(),
+_rootCounts(),
+_nextRootMove(0)
 {
+	if (hashSize) {
+		// the number of entries is the largest power of 2 fitting into hashSize
+		uint64_t entryCount = 1;
+		while (2 * entryCount * sizeof(PerftEntry) <= (uint64_t) hashSize * 1024 * 1024) {
+			entryCount *= 2;
+		}
+		std::vector<PerftEntry> hash(entryCount);
+		_hash.swap(hash);
+		_hashMask = entryCount - 1;
+	}
 }
 
 Perft::~Perft()
@@ -2,21 +2,29 @@
 #define PERFT_H_
 
 #include "utils.h"
+#include <vector>
+#include <atomic>
 
 namespace pismo
 {
 class PositionState;
 
+// Default size of the perft hash in MB
+const unsigned int DEFAULT_PERFT_HASH_SIZE = 64;
+
 class Perft
 {
 public:
 	/*
 	 * Counts the leaf nodes of the game for PositionState
-	 * pos at the depth
+	 * pos at the depth, the root moves are split between
+	 * the threads, if divide is true the count of each root
+	 * move and the speed are printed to stdout
 	 */
-	uint64_t analyze(PositionState& pos, uint16_t depth, bool begin = false) const;
+	uint64_t analyze(const PositionState& pos, uint16_t depth, bool divide = false);
 
-	Perft();
+	// hashSize is in MB, 0 disables the perft hash
+	Perft(unsigned int threadCount = 1, unsigned int hashSize = DEFAULT_PERFT_HASH_SIZE);
 
 	~Perft();
 
@@ -25,9 +33,32 @@ private:
 	Perft(const Perft&); //non-copy constructable
 	Perft& operator=(const Perft&); //non-assignable
 
+	// Entry of the perft hash shared by the threads without
+	// locking, key is stored xored with data, so that torn
+	// entries written by two threads are not matched
+	struct PerftEntry {
+		std::atomic<uint64_t> key;
+		// leaf count in the upper bits and depth in the lowest byte
+		std::atomic<uint64_t> data;
+	};
+
+	// Takes the root moves one by one and counts their
+	// subtrees on the own copy of pos
+	void analyzeRootMoves(const PositionState& pos, uint16_t depth);
+	uint64_t countNodes(PositionState& pos, uint16_t depth);
+
+	bool probeHash(ZobKey key, uint16_t depth, uint64_t& count) const;
+	void storeHash(ZobKey key, uint16_t depth, uint64_t count);
+
+	unsigned int _threadCount;
+	std::vector<PerftEntry> _hash;
+	uint64_t _hashMask;
+
+	std::vector<MoveInfo> _rootMoves;
+	std::vector<uint64_t> _rootCounts;
+	std::atomic<std::size_t> _nextRootMove;
 };
 
 }
 
 #endif //PERFT_H_
-
@@ -4,15 +4,40 @@
 #include <fstream>
 #include <string>
 #include <cctype>
-#include <ctime>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <thread>
 #include <iostream>
 
 void parseInputInfo(const std::string& line, std::string& fen, uint16_t& depth, uint64_t& goldenOutput);
 
 int main(int argc, char* argv[])
 {
-	if (argc != 3) {
-		std::cout << "\nUsage:\n     " << argv[0] << " input_file output_file\n" << std::endl;
+	unsigned int defaultThreadCount = std::thread::hardware_concurrency();
+	if (!defaultThreadCount) {
+		defaultThreadCount = 1;
+	}
+
+	if (argc >= 5 && !std::strcmp(argv[1], "divide")) {
+		// the fields of the FEN are passed as separate arguments
+		std::string fen = argv[4];
+		for (int i = 5; i < argc; ++i) {
+			fen += ' ';
+			fen += argv[i];
+		}
+		pismo::MemPool::initMoveGenInfo();
+		pismo::MemPool::initCheckPinInfo();
+		pismo::PositionState pos;
+		pos.initPositionFEN(fen);
+		pismo::Perft perft(std::atoi(argv[3]));
+		perft.analyze(pos, std::atoi(argv[2]), true);
+		pismo::MemPool::destroyMoveGenInfo();
+		pismo::MemPool::destroyCheckPinInfo();
+	}
+	else if (argc < 3 || argc > 5) {
+		std::cout << "\nUsage:\n     " << argv[0] << " input_file output_file [thread_count [hash_size_mb]]\n"
+			<< "     " << argv[0] << " divide depth thread_count fen\n" << std::endl;
 	}
 	else {
 		std::ifstream ifStream;
@@ -24,6 +49,10 @@ int main(int argc, char* argv[])
 			std::string line;
 			pismo::MemPool::initMoveGenInfo();
 			pismo::MemPool::initCheckPinInfo();
+			// the hash is not cleared between the positions,
+			// as the entries are valid for any position
+			pismo::Perft perft(argc > 3 ? std::atoi(argv[3]) : defaultThreadCount,
+					argc > 4 ? std::atoi(argv[4]) : pismo::DEFAULT_PERFT_HASH_SIZE);
 			while(std::getline(ifStream, line)) {
 				std::string fen;
 				uint16_t depth;
@@ -31,19 +60,20 @@ int main(int argc, char* argv[])
 				parseInputInfo(line, fen, depth, goldenOutput);
 				pismo::PositionState pos;
 				pos.initPositionFEN(fen);
-				pismo::Perft perft;
-				std::time_t start = time(NULL);
-				uint64_t moveCount = perft.analyze(pos, depth, true);
-				std::time_t end = time(NULL);
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				uint64_t moveCount = perft.analyze(pos, depth);
+				std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
 				if (moveCount == goldenOutput) {
 					ofStream << "PASSED: ";
 				}
 				else {
 					ofStream << "FAILED: ";
 				}
-				ofStream << end - start << "sec " << moveCount 
+				ofStream << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms " << moveCount 
 						<< " " << goldenOutput << " " << fen << " " << depth << std::endl;
 			}	
+			pismo::MemPool::destroyMoveGenInfo();
+			pismo::MemPool::destroyCheckPinInfo();
 		}
 		else {
 			if(!ifStream.is_open()) {
@@ -59,8 +89,6 @@ int main(int argc, char* argv[])
 		if (ofStream.is_open()) {
 			ofStream.close();
 		}
-		pismo::MemPool::destroyMoveGenInfo();
-		pismo::MemPool::destroyCheckPinInfo();
 	}
 }
 
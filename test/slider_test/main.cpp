@@ -0,0 +1,83 @@
+#include "SliderAttacks.h"
+#include <string>
+#include <iostream>
+
+// Cross-check of the slider attacks backends against magicmoves:
+// for each square every subset of the relevant occupancy is
+// checked, both alone and with random pieces outside of it
+// (which must not change the attacks), plus random boards
+
+const unsigned int RANDOM_BOARD_COUNT = 1000000;
+
+uint64_t randomState = 0x2545F4914F6CDD1DULL;
+
+uint64_t randomBoard()
+{
+	randomState ^= randomState >> 12;
+	randomState ^= randomState << 25;
+	randomState ^= randomState >> 27;
+	return randomState * 2685821657736338717ULL;
+}
+
+template <typename Backend>
+bool checkOccupancy(const Backend& backend, const pismo::MagicMovesSliders& reference,
+		pismo::Square sq, pismo::Bitboard occupied, uint64_t& failures)
+{
+	if (backend.rookAttacks(sq, occupied) != reference.rookAttacks(sq, occupied) ||
+			backend.bishopAttacks(sq, occupied) != reference.bishopAttacks(sq, occupied)) {
+		if (failures++ == 0) {
+			std::cout << "  first mismatch: square " << sq << " occupancy 0x" << std::hex << occupied << std::dec << std::endl;
+		}
+		return false;
+	}
+
+	return true;
+}
+
+template <typename Backend>
+bool checkBackend(const std::string& name, const Backend& backend, const pismo::MagicMovesSliders& reference)
+{
+	uint64_t checks = 0;
+	uint64_t failures = 0;
+	for (unsigned int sq = pismo::A1; sq <= pismo::H8; ++sq) {
+		const pismo::Bitboard masks[] = {magicmoves_r_mask[sq], magicmoves_b_mask[sq]};
+		for (unsigned int m = 0; m < 2; ++m) {
+			pismo::Bitboard occupied = 0;
+			do {
+				checkOccupancy(backend, reference, (pismo::Square) sq, occupied, failures);
+				checkOccupancy(backend, reference, (pismo::Square) sq, occupied | (randomBoard() & ~masks[m]), failures);
+				checks += 2;
+				occupied = (occupied - masks[m]) & masks[m];
+			} while (occupied);
+		}
+	}
+	for (unsigned int i = 0; i < RANDOM_BOARD_COUNT; ++i) {
+		// boards with about a quarter of the squares occupied
+		pismo::Bitboard occupied = randomBoard() & randomBoard();
+		checkOccupancy(backend, reference, (pismo::Square) (i % pismo::SQUARES_COUNT), occupied, failures);
+		++checks;
+	}
+
+	std::cout << (failures ? "FAILED: " : "PASSED: ") << name << " " << checks << " occupancies, "
+		<< failures << " mismatches" << std::endl;
+	return !failures;
+}
+
+int main()
+{
+	pismo::MagicMovesSliders reference;
+	bool passed = true;
+
+	pismo::FancyMagicSliders fancyMagic;
+	passed &= checkBackend("fancy magic", fancyMagic, reference);
+#ifdef __BMI2__
+	pismo::PextSliders pext;
+	passed &= checkBackend("pext", pext, reference);
+#else
+	std::cout << "SKIPPED: pext (build with make ARCH=bmi2)" << std::endl;
+#endif
+	pismo::KoggeStoneSliders koggeStone;
+	passed &= checkBackend("kogge-stone", koggeStone, reference);
+
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+#include "PositionState.h"
+#include "ABCore.h"
+#include "MemPool.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+
+// Time-to-depth benchmark of the Lazy SMP search:
+// searches every position of the input file to the fixed
+// depth with 1, 2, 4, 8 and 16 threads and prints the
+// elapsed time and the speedup relative to one thread
+
+const unsigned int THREAD_COUNTS[] = {1, 2, 4, 8, 16};
+
+// Input lines are in the perft positions format (FEN followed
+// by perft depth and move count), only the FEN part is used
+std::string parseFen(const std::string& line)
+{
+	std::istringstream lineStream(line);
+	std::string fen;
+	std::string field;
+	for (unsigned int i = 0; i < 6 && lineStream >> field; ++i) {
+		if (i != 0) {
+			fen.push_back(' ');
+		}
+		fen.append(field);
+	}
+
+	return fen;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 3) {
+		std::cout << "\nUsage:\n     " << argv[0] << " input_file depth\n" << std::endl;
+		return 1;
+	}
+
+	std::ifstream ifStream(argv[1]);
+	if (!ifStream.is_open()) {
+		std::cout << "Cannot open the " << argv[1] << " file for reading" << std::endl;
+		return 1;
+	}
+	uint16_t depth = std::atoi(argv[2]);
+
+	std::vector<std::string> fens;
+	std::string line;
+	while (std::getline(ifStream, line)) {
+		if (!line.empty()) {
+			fens.push_back(parseFen(line));
+		}
+	}
+
+	pismo::MemPool::initMoveGenInfo();
+	pismo::MemPool::initCheckPinInfo();
+
+	std::cout << "Threads\tTime(ms)\tSpeedup" << std::endl;
+	double singleThreadTime = 0;
+	for (unsigned int t = 0; t < sizeof(THREAD_COUNTS) / sizeof(THREAD_COUNTS[0]); ++t) {
+		double totalTime = 0;
+		for (std::size_t i = 0; i < fens.size(); ++i) {
+			// new engine for each search, so that the
+			// transposition table is empty
+			pismo::ABCore* engine = new pismo::ABCore();
+			engine->setThreadCount(THREAD_COUNTS[t]);
+			pismo::PositionState pos;
+			pos.initPositionFEN(fens[i]);
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			engine->think(pos, depth);
+			std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+			totalTime += std::chrono::duration<double, std::milli>(end - start).count();
+			delete engine;
+		}
+		if (t == 0) {
+			singleThreadTime = totalTime;
+		}
+		std::cout << THREAD_COUNTS[t] << "\t" << std::fixed << std::setprecision(0) << totalTime << "\t\t"
+			<< std::setprecision(2) << singleThreadTime / totalTime << std::endl;
+	}
+
+	pismo::MemPool::destroyMoveGenInfo();
+	pismo::MemPool::destroyCheckPinInfo();
+
+	return 0;
+}
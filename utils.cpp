@@ -40,15 +40,22 @@ std::string moveToNotation(const MoveInfo& move)
   return str;
 }
 
-//returns number of bits in val
-//TODO: if hardware suppports instruction for pop count
-//http://0x80.pl/articles/sse-popcount.html
-int bitCount(uint64_t val)
+bool cpuSupportsBuild()
 {
-	val = val - ((val >> 1) & 0x5555555555555555);
-	val = (val & 0x3333333333333333) + ((val >> 2) & 0x3333333333333333);
-	val = (val + (val >> 4)) & 0x0f0f0f0f0f0f0f0f;
-	return (val * 0x0101010101010101) >> 56;
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+#ifdef __POPCNT__
+	if (!__builtin_cpu_supports("popcnt")) {
+		return false;
+	}
+#endif
+#ifdef __BMI2__
+	if (!__builtin_cpu_supports("bmi2")) {
+		return false;
+	}
+#endif
+#endif
+	return true;
 }
 
 }
@@ -60,14 +60,14 @@ enum GamePhase
 
 enum MoveType {
 	NORMAL_MOVE = 0, CAPTURE_MOVE, PROMOTION_MOVE, CASTLING_MOVE,
-        EN_PASSANT_MOVE, EN_PASSANT_CAPTURE
+        EN_PASSANT_MOVE, EN_PASSANT_CAPTURE, NULL_MOVE
 };
 
 enum MoveGenerationStage {
-	GOOD_CAPTURING_MOVES = 0, BAD_CAPTURING_MOVES,
-   	CHECKING_MOVES,	QUITE_MOVES, EVASION_MOVES,
+	TRANS_TABLE_MOVE = 0, GOOD_CAPTURING_MOVES, BAD_CAPTURING_MOVES,
+   	CHECKING_MOVES,	KILLER_MOVES, QUITE_MOVES, EVASION_MOVES,
 	SEARCH_FINISHED
-}; //TODO: Later add KILLER_MOVES
+};
 
 enum SearchType {
 	USUAL_SEARCH = 0,
@@ -93,20 +93,40 @@ struct MoveInfo {
 
 const MoveInfo MATE_MOVE = MoveInfo();
 
+// Returns true if the move is neither capture nor promotion,
+// the move type should be valid
+inline bool isQuietMove(const MoveInfo& move)
+{
+	return move.type == NORMAL_MOVE || move.type == CASTLING_MOVE || move.type == EN_PASSANT_MOVE;
+}
+
+// Shows how the stored evaluation relates to the real value of the position:
+// UPPER_BOUND - real value is less or equal (the search failed low)
+// LOWER_BOUND - real value is greater or equal (the search failed high)
+// EXACT_BOUND - real value is equal
+enum BoundType {
+	NO_BOUND = 0, UPPER_BOUND, LOWER_BOUND, EXACT_BOUND
+};
+
 struct EvalInfo
 {
 	int16_t posValue;
 	ZobKey zobKey;
 	uint16_t depth;
+	BoundType bound;
+
+	// The best move found in the position, or the move
+	// which caused the cutoff (only from, to and promoted are kept)
+	MoveInfo move;
 	
-	EvalInfo(int16_t v = 0, ZobKey z = 0, uint16_t d = 0)
+	EvalInfo(int16_t v = 0, ZobKey z = 0, uint16_t d = 0, BoundType b = EXACT_BOUND, const MoveInfo& m = MoveInfo())
   	: posValue(v),
     	zobKey(z),
-    	depth(d)
+    	depth(d),
+    	bound(b),
+    	move(m)
   	{
   	}
-
-	//TODO:Add later best move
 };
 
 // Material Piece values according to enum Piece 
@@ -114,7 +134,54 @@ const int PIECE_VALUES[PIECE_COUNT] =
 	{100,  325,  325,  500,  975,  0,
 	100, 325, 325, 500, 975, 0};
 
-const int16_t MAX_SCORE = 10000; //white has 100% winning position (-MAX_SCORE black wins)
+// Search scores are relative to the side to move (negamax),
+// while the static evaluation is relative to white
+const int16_t MAX_SCORE = 10000; //side to move has 100% winning position (-MAX_SCORE it is mated)
+const int16_t DRAW_SCORE = 0;
+
+// Mate scores depend on the distance from the root, the side to move
+// mated at ply n gets -MAX_SCORE + n, so that the shorter mates are
+// preferred, the scores beyond MATE_BOUND are mate scores
+const int16_t MAX_MATE_PLY = 128;
+const int16_t MATE_BOUND = MAX_SCORE - MAX_MATE_PLY;
+
+inline bool isMateScore(int16_t score)
+{
+	return score >= MATE_BOUND || score <= -MATE_BOUND;
+}
+
+// The functions counting the bits in the loops are compiled
+// twice by the dispatch build (make ARCH=dispatch), with and
+// without popcnt, and the version is chosen at startup by CPUID;
+// the functions they call are forced inline with POPCNT_INLINE,
+// so that their bit counts are compiled in the clones as well
+#ifdef POPCNT_DISPATCH
+#define POPCNT_CLONES __attribute__((target_clones("popcnt", "default")))
+#define POPCNT_INLINE inline __attribute__((always_inline))
+#else
+#define POPCNT_CLONES
+#define POPCNT_INLINE
+#endif
+
+// Returns number of bits in val, the popcnt instruction
+// is used if the build targets it (make ARCH=popcnt or bmi2),
+// GCC also compiles the SWAR code to popcnt in the popcnt clones
+// http://0x80.pl/articles/sse-popcount.html
+inline int bitCount(uint64_t val)
+{
+#ifdef __POPCNT__
+	return __builtin_popcountll(val);
+#else
+	val = val - ((val >> 1) & 0x5555555555555555);
+	val = (val & 0x3333333333333333) + ((val >> 2) & 0x3333333333333333);
+	val = (val + (val >> 4)) & 0x0f0f0f0f0f0f0f0f;
+	return (val * 0x0101010101010101) >> 56;
+#endif
+}
+
+// Returns true if the CPU supports the instructions the
+// binary was built for (checked once at startup)
+bool cpuSupportsBuild();
 
 std::string moveToNotation(const MoveInfo& move);
 std::string getPromoted(Piece piece);